@@ -0,0 +1,388 @@
+#include "radix_sort.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <functional>
+#include <type_traits>
+
+// Benchmark of the radix sort variants against std::sort and std::stable_sort.
+//
+// Usage: benchmark [--sizes N,N,...] [--types T,T,...] [--distributions D,D,...]
+//                  [--algorithms A,A,...] [--min-time SECONDS] [--min-reps N] [--max-reps N]
+//                  [--format csv|json] [--no-verify]
+//
+// Every (type, distribution, size, algorithm) combination is run once as a warmup and
+// then repeated until both min-reps repetitions and min-time seconds of wall-clock time
+// are reached, or max-reps is. Every repetition sorts a fresh copy of the same input.
+// One CSV line or JSON object per combination is written to stdout, with the best and
+// median time per element and the throughput in GB/s (input bytes / best time).
+// Sizes may be written as 1e9; an input of N elements needs about 4 * N * sizeof(T) bytes
+// of memory (input, reference result, copy being sorted and its temporary buffer),
+// one copy less with --no-verify.
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+struct Options
+{
+    vector<size_t> sizes = { 1000, 10000, 100000, 1000000, 10000000 };
+    vector<string> types = { "uint32_t", "uint64_t", "int64_t", "float", "double" };
+    vector<string> distributions = { "uniform", "sorted", "reverse", "nearly_sorted", "few_unique",
+                                     "zipf", "gaussian", "small_range", "all_equal" };
+    vector<string> algorithms = { "std::sort", "std::stable_sort", "radix_sort", "radix_sort_workspace",
+                                  "radix_sort<11>", "radix_sort_in_place", "radix_sort_parallel",
+                                  "radix_sort_hybrid" };
+    double min_time = 0.5;
+    size_t min_reps = 3;
+    size_t max_reps = 1000;
+    bool json = false;
+    bool verify = true;
+};
+
+vector<string> split(const string& list)
+{
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+
+    while (getline(stream, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+
+    return items;
+}
+
+bool contains(const vector<string>& list, const string& item)
+{
+    return find(list.begin(), list.end(), item) != list.end();
+}
+
+// Maps a uniformly distributed unsigned integer to a T spread over its whole range.
+template <typename T>
+T from_bits(uint64_t bits, true_type /* integral */)
+{
+    return T(bits);
+}
+
+template <typename T>
+T from_bits(uint64_t bits, false_type /* floating point */)
+{
+    // Uniform in [-1, 1) times a large scale: all signs and many exponents, no NaNs.
+    return T((double(bits >> 11) / double(uint64_t(1) << 52) - 1.0) * 1e6);
+}
+
+template <typename T>
+T from_bits(uint64_t bits)
+{
+    return from_bits<T>(bits, is_integral<T>());
+}
+
+// Middle of the range of T, the center of the Gaussian distribution.
+template <typename T>
+double center()
+{
+    return is_integral<T>::value ? (double(numeric_limits<T>::max()) + double(numeric_limits<T>::min())) / 2 : 0.0;
+}
+
+template <typename T>
+vector<T> generate_input(const string& distribution, size_t size, uint64_t seed)
+{
+    mt19937_64 generator(seed);
+    vector<T> values(size);
+
+    if (distribution == "uniform" || distribution == "sorted" || distribution == "reverse" ||
+        distribution == "nearly_sorted")
+    {
+        for (T& v : values)
+            v = from_bits<T>(generator());
+
+        if (distribution == "sorted" || distribution == "nearly_sorted")
+            sort(values.begin(), values.end());
+        else if (distribution == "reverse")
+            sort(values.begin(), values.end(), greater<T>());
+
+        // 1% of the elements, at random positions, replaced by random values.
+        if (distribution == "nearly_sorted")
+            for (size_t i = 0; i < size / 100; ++i)
+                values[generator() % size] = from_bits<T>(generator());
+    }
+    else if (distribution == "few_unique")
+    {
+        T unique[16];
+
+        for (T& v : unique)
+            v = from_bits<T>(generator());
+
+        for (T& v : values)
+            v = unique[generator() % 16];
+    }
+    else if (distribution == "zipf")
+    {
+        // Zipf with exponent 1 over one million distinct random values.
+        const size_t ranks = 1000000;
+
+        vector<double> cdf(ranks);
+        vector<T> keys(ranks);
+        double sum = 0;
+
+        for (size_t i = 0; i < ranks; ++i)
+        {
+            sum += 1.0 / double(i + 1);
+            cdf[i] = sum;
+            keys[i] = from_bits<T>(generator());
+        }
+
+        uniform_real_distribution<double> uniform(0, sum);
+
+        for (T& v : values)
+            v = keys[min(size_t(lower_bound(cdf.begin(), cdf.end(), uniform(generator)) - cdf.begin()), ranks - 1)];
+    }
+    else if (distribution == "gaussian")
+    {
+        const double stddev = is_integral<T>::value ? pow(2.0, sizeof(T) * 4) : 1000.0;
+
+        normal_distribution<double> normal(center<T>(), stddev);
+
+        for (T& v : values)
+            v = T(normal(generator));
+    }
+    else if (distribution == "small_range")
+    {
+        // 20 significant bits in a wide type: ids, counters, short time ranges.
+        for (T& v : values)
+            v = T(generator() & ((uint64_t(1) << 20) - 1));
+    }
+    else if (distribution == "all_equal")
+    {
+        fill(values.begin(), values.end(), from_bits<T>(generator()));
+    }
+    else
+    {
+        cerr << "Unknown distribution " << distribution << endl;
+        exit(1);
+    }
+
+    return values;
+}
+
+template <typename T>
+struct Algorithm
+{
+    string name;
+    function<void(vector<T>&)> sort;
+};
+
+template <typename T>
+vector<Algorithm<T>> algorithms(RadixSort::Workspace& workspace)
+{
+    vector<Algorithm<T>> all;
+
+    all.push_back({ "std::sort", [](vector<T>& v) { std::sort(v.begin(), v.end()); } });
+    all.push_back({ "std::stable_sort", [](vector<T>& v) { std::stable_sort(v.begin(), v.end()); } });
+    all.push_back({ "radix_sort", [](vector<T>& v) { RadixSort::radix_sort(v.data(), v.size()); } });
+    all.push_back({ "radix_sort_workspace", [&workspace](vector<T>& v)
+    {
+        RadixSort::radix_sort(v.data(), v.size(), workspace);
+    } });
+    all.push_back({ "radix_sort<11>", [](vector<T>& v) { RadixSort::radix_sort<11>(v.data(), v.size()); } });
+    all.push_back({ "radix_sort_in_place", [](vector<T>& v) { RadixSort::radix_sort_in_place(v.data(), v.size()); } });
+    all.push_back({ "radix_sort_parallel", [](vector<T>& v) { RadixSort::radix_sort_parallel(v.data(), v.size()); } });
+    all.push_back({ "radix_sort_hybrid", [](vector<T>& v) { RadixSort::radix_sort_hybrid(v.data(), v.size()); } });
+
+    return all;
+}
+
+// Compares values, not bits: the radix sorts order -0 before +0, the std sorts keep them as they are.
+template <typename T>
+bool same_values(const vector<T>& a, const vector<T>& b)
+{
+    return a.size() == b.size() && equal(a.begin(), a.end(), b.begin());
+}
+
+struct Result
+{
+    string type;
+    string distribution;
+    size_t size;
+    string algorithm;
+    size_t reps;
+    double best_ns_per_element;
+    double median_ns_per_element;
+    double gb_per_second;
+};
+
+void print_header(const Options& options)
+{
+    if (options.json)
+        cout << "[" << endl;
+    else
+        cout << "type,distribution,size,algorithm,reps,best_ns_per_element,median_ns_per_element,gb_per_second" << endl;
+}
+
+void print_result(const Options& options, const Result& r, bool first)
+{
+    if (options.json)
+    {
+        cout << (first ? "  " : ", ") << "{\"type\": \"" << r.type << "\", \"distribution\": \"" << r.distribution
+             << "\", \"size\": " << r.size << ", \"algorithm\": \"" << r.algorithm << "\", \"reps\": " << r.reps
+             << ", \"best_ns_per_element\": " << r.best_ns_per_element
+             << ", \"median_ns_per_element\": " << r.median_ns_per_element
+             << ", \"gb_per_second\": " << r.gb_per_second << "}" << endl;
+    }
+    else
+    {
+        cout << r.type << "," << r.distribution << "," << r.size << "," << r.algorithm << "," << r.reps << ","
+             << r.best_ns_per_element << "," << r.median_ns_per_element << "," << r.gb_per_second << endl;
+    }
+}
+
+void print_footer(const Options& options)
+{
+    if (options.json)
+        cout << "]" << endl;
+}
+
+template <typename T>
+void run_type(const Options& options, const string& type_name, bool& first)
+{
+    if (!contains(options.types, type_name))
+        return;
+
+    RadixSort::Workspace workspace;
+
+    const vector<Algorithm<T>> all = algorithms<T>(workspace);
+
+    for (const string& distribution : options.distributions)
+    {
+        for (size_t size : options.sizes)
+        {
+            const vector<T> input = generate_input<T>(distribution, size, size);
+
+            vector<T> expected;
+
+            if (options.verify)
+            {
+                expected = input;
+                std::stable_sort(expected.begin(), expected.end());
+            }
+
+            for (const Algorithm<T>& algorithm : all)
+            {
+                if (!contains(options.algorithms, algorithm.name))
+                    continue;
+
+                vector<T> data = input;
+
+                // Warmup, also used to verify the result.
+                algorithm.sort(data);
+
+                if (options.verify && !same_values(data, expected))
+                {
+                    cerr << algorithm.name << " failed on " << type_name << " " << distribution << " " << size << endl;
+                    exit(1);
+                }
+
+                vector<double> times;
+                double total = 0;
+
+                while (times.size() < options.max_reps &&
+                       (times.size() < options.min_reps || total < options.min_time))
+                {
+                    data = input;
+
+                    const Clock::time_point start = Clock::now();
+                    algorithm.sort(data);
+                    const double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+                    times.push_back(seconds);
+                    total += seconds;
+                }
+
+                sort(times.begin(), times.end());
+
+                const double elements = double(max(size, size_t(1)));
+
+                Result result;
+                result.type = type_name;
+                result.distribution = distribution;
+                result.size = size;
+                result.algorithm = algorithm.name;
+                result.reps = times.size();
+                result.best_ns_per_element = times.front() * 1e9 / elements;
+                result.median_ns_per_element = times[times.size() / 2] * 1e9 / elements;
+                result.gb_per_second = double(size * sizeof(T)) / times.front() / 1e9;
+
+                print_result(options, result, first);
+                first = false;
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (arg == "--sizes" && has_value)
+        {
+            options.sizes.clear();
+
+            for (const string& s : split(argv[++i]))
+                options.sizes.push_back(size_t(strtod(s.c_str(), nullptr)));
+        }
+        else if (arg == "--types" && has_value)
+            options.types = split(argv[++i]);
+        else if (arg == "--distributions" && has_value)
+            options.distributions = split(argv[++i]);
+        else if (arg == "--algorithms" && has_value)
+            options.algorithms = split(argv[++i]);
+        else if (arg == "--min-time" && has_value)
+            options.min_time = strtod(argv[++i], nullptr);
+        else if (arg == "--min-reps" && has_value)
+            options.min_reps = size_t(strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--max-reps" && has_value)
+            options.max_reps = size_t(strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--format" && has_value)
+            options.json = string(argv[++i]) == "json";
+        else if (arg == "--no-verify")
+            options.verify = false;
+        else
+        {
+            cerr << "Usage: " << argv[0] << " [--sizes N,N,...] [--types T,T,...] [--distributions D,D,...]\n"
+                    "    [--algorithms A,A,...] [--min-time SECONDS] [--min-reps N] [--max-reps N]\n"
+                    "    [--format csv|json] [--no-verify]\n";
+            return 1;
+        }
+    }
+
+    options.min_reps = max(options.min_reps, size_t(1));
+    options.max_reps = max(options.max_reps, options.min_reps);
+
+    bool first = true;
+
+    print_header(options);
+
+    run_type<uint16_t>(options, "uint16_t", first);
+    run_type<int16_t>(options, "int16_t", first);
+    run_type<uint32_t>(options, "uint32_t", first);
+    run_type<int32_t>(options, "int32_t", first);
+    run_type<uint64_t>(options, "uint64_t", first);
+    run_type<int64_t>(options, "int64_t", first);
+    run_type<float>(options, "float", first);
+    run_type<double>(options, "double", first);
+
+    print_footer(options);
+}
@@ -1,13 +1,24 @@
 #include "radix_sort.hpp"
+#include "radix_sort_string.hpp"
+#include "radix_sort_external.hpp"
 
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <ctime>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <fstream>
 #include <string>
 #include <cassert>
 #include <random>
 #include <type_traits>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <stdexcept>
 
 using namespace std;
 
@@ -76,11 +87,12 @@ double test(string function_name, F sorting_function, const unsigned num_of_elem
 
     vector<T> copy = main;
 
-    clock_t start = clock();
+    // Wall-clock time: clock() would add up the CPU time of all threads of a parallel sort.
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
 
     sorting_function(main);
 
-    double total = (clock() - start) / double(CLOCKS_PER_SEC);
+    double total = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
     cout << function_name << " | Time " << total <<
          " sec";
@@ -116,6 +128,896 @@ REGISTER_TYPE_NAME(uint32_t);
 REGISTER_TYPE_NAME(uint64_t);
 REGISTER_TYPE_NAME(int64_t);
 REGISTER_TYPE_NAME(float);
+REGISTER_TYPE_NAME(double);
+
+// Checks a result against the one computed with the standard library.
+template <typename T>
+void check_equal(string function_name, const vector<T> & result, const vector<T> & expected)
+{
+    if(result != expected)
+    {
+        cout << function_name << ": wrong result" << endl;
+        exit(1);
+    }
+
+    cout << function_name << " | OK, " << result.size() << " elements" << endl;
+}
+
+// Sorts values with sorting_function and checks the result against std::stable_sort.
+template <typename T, typename F>
+void check(string function_name, F sorting_function, vector<T> values)
+{
+    vector<T> expected = values;
+
+    std::stable_sort(expected.begin(), expected.end());
+
+    sorting_function(values);
+
+    check_equal(function_name, values, expected);
+}
+
+// radix_select and radix_partial_sort with k = size / 3. Sorting the parts that they
+// leave unordered must give the same array as sorting all of it.
+template <typename T>
+void check_selection()
+{
+    vector<T> values(1000000);
+
+    generate(values.begin(), values.end(), random_values<T>());
+
+    const size_t k = values.size() / 3;
+
+    check(string("radix_select, ") + TypeData<T>::name, [k](vector<T> & v)
+    {
+        RadixSort::radix_select(v.data(), v.size(), k);
+        std::sort(v.begin(), v.begin() + k);
+        std::sort(v.begin() + k + 1, v.end());
+    }, values);
+
+    check(string("radix_partial_sort, ") + TypeData<T>::name, [k](vector<T> & v)
+    {
+        vector<T> temp(k);
+        RadixSort::radix_partial_sort(v.data(), v.size(), k, temp.data());
+        std::sort(v.begin() + k, v.end());
+    }, values);
+}
+
+template <typename T>
+void check_parallel()
+{
+    vector<T> values(1000000);
+
+    generate(values.begin(), values.end(), random_values<T>());
+
+    check(string("radix_sort_parallel, 4 threads, ") + TypeData<T>::name, [](vector<T> & v)
+    {
+        RadixSort::radix_sort_parallel(v.data(), v.size(), size_t(4));
+    }, values);
+}
+
+// Rows of (key, row number) with 1000 distinct keys. std::stable_sort orders them by key and
+// then row number, which is the order a stable sort by key leaves the row numbers in.
+template <typename K>
+void check_by_key()
+{
+    vector<pair<K, uint32_t>> rows(1000000);
+
+    random_values<K> random_value;
+
+    for(size_t i = 0; i < rows.size(); ++i)
+        rows[i] = make_pair(K(random_value() % 1000), uint32_t(i));
+
+    check(string("radix_sort_by_key, ") + TypeData<K>::name, [](vector<pair<K, uint32_t>> & v)
+    {
+        vector<K> keys(v.size());
+        vector<uint32_t> values(v.size());
+
+        for(size_t i = 0; i < v.size(); ++i)
+        {
+            keys[i] = v[i].first;
+            values[i] = v[i].second;
+        }
+
+        RadixSort::radix_sort_by_key(keys.data(), values.data(), v.size());
+
+        for(size_t i = 0; i < v.size(); ++i)
+            v[i] = make_pair(keys[i], values[i]);
+    }, rows);
+
+    check(string("radix_argsort, ") + TypeData<K>::name, [](vector<pair<K, uint32_t>> & v)
+    {
+        vector<K> keys(v.size());
+        vector<uint32_t> indices(v.size());
+
+        for(size_t i = 0; i < v.size(); ++i)
+            keys[i] = v[i].first;
+
+        RadixSort::radix_argsort(keys.data(), v.size(), indices.data());
+
+        const vector<pair<K, uint32_t>> unsorted = v;
+
+        for(size_t i = 0; i < v.size(); ++i)
+            v[i] = unsorted[indices[i]];
+    }, rows);
+}
+
+template <typename T>
+void check_in_place()
+{
+    vector<T> values(1000000);
+
+    generate(values.begin(), values.end(), random_values<T>());
+
+    check(string("radix_sort_in_place, ") + TypeData<T>::name, [](vector<T> & v)
+    {
+        RadixSort::radix_sort_in_place(v.data(), v.size());
+    }, values);
+}
+
+// A small record, moved by every pass when sorted by key projection. std::stable_sort
+// orders it by timestamp; row is the position in the input, so stability is checked too.
+struct Trade
+{
+    int64_t timestamp;
+    uint32_t row;
+};
+
+bool operator<(const Trade & a, const Trade & b)
+{
+    return a.timestamp < b.timestamp;
+}
+
+bool operator==(const Trade & a, const Trade & b)
+{
+    return a.timestamp == b.timestamp && a.row == b.row;
+}
+
+bool operator!=(const Trade & a, const Trade & b)
+{
+    return !(a == b);
+}
+
+void check_projection()
+{
+    vector<Trade> trades(1000000);
+
+    random_values<int64_t> random_value;
+
+    for(size_t i = 0; i < trades.size(); ++i)
+        trades[i] = Trade{ random_value() % 10000, uint32_t(i) };
+
+    check("radix_sort, trades by key", [](vector<Trade> & v)
+    {
+        RadixSort::radix_sort(v.data(), v.size(), [](const Trade & t) { return t.timestamp; });
+    }, trades);
+}
+
+// Segments of 0 to 299 elements with the values of segment i in [1000 i, 1000 i + 1000), so
+// that sorting every segment on its own sorts the whole array.
+void check_segmented()
+{
+    mt19937 generator(1);
+
+    vector<uint32_t> values;
+    vector<size_t> offsets(1, 0);
+
+    for(uint32_t segment = 0; segment < 10000; ++segment)
+    {
+        const size_t length = generator() % 300;
+
+        for(size_t i = 0; i < length; ++i)
+            values.push_back(segment * 1000 + generator() % 1000);
+
+        offsets.push_back(values.size());
+    }
+
+    check("radix_sort_segmented", [&offsets](vector<uint32_t> & v)
+    {
+        RadixSort::radix_sort_segmented(v.data(), offsets.data(), offsets.size() - 1);
+    }, values);
+
+    // The same segments sorted one by one: those under 48 elements take the small array path.
+    check("radix_sort, one segment at a time", [&offsets](vector<uint32_t> & v)
+    {
+        for(size_t i = 0; i + 1 < offsets.size(); ++i)
+            RadixSort::radix_sort(v.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }, values);
+}
+
+// One Workspace for sorts of different sizes and types, which grows and reuses its buffer.
+void check_workspace()
+{
+    RadixSort::Workspace workspace;
+
+    for(size_t size : { size_t(1000), size_t(1000000), size_t(1000) })
+    {
+        vector<uint64_t> values(size);
+
+        generate(values.begin(), values.end(), random_values<uint64_t>());
+
+        check("radix_sort with a Workspace, uint64_t", [&workspace](vector<uint64_t> & v)
+        {
+            RadixSort::radix_sort(v.data(), v.size(), workspace);
+        }, values);
+    }
+
+    vector<float> floats(1000000);
+
+    generate(floats.begin(), floats.end(), random_values<float>());
+
+    check("radix_sort with a Workspace, float", [&workspace](vector<float> & v)
+    {
+        RadixSort::radix_sort(v.data(), v.size(), workspace);
+    }, floats);
+
+    vector<int32_t> integers(1000000);
+
+    generate(integers.begin(), integers.end(), random_values<int32_t>());
+
+    check("radix_sort_parallel with a Workspace, 4 threads, int32_t", [&workspace](vector<int32_t> & v)
+    {
+        RadixSort::radix_sort_parallel(v.data(), v.size(), workspace, 4);
+    }, integers);
+}
+
+// Keys whose high bytes are all equal, which the pass planner skips or re-counts.
+void check_pass_planning()
+{
+    mt19937_64 generator(1);
+
+    vector<uint64_t> small_values(1000000), shifted_values(1000000), timestamps(1000000);
+    vector<int64_t> signed_values(1000000);
+
+    for(size_t i = 0; i < small_values.size(); ++i)
+    {
+        small_values[i] = generator() & 0xffffff;
+        shifted_values[i] = (generator() & 0xffff) << 4;
+        timestamps[i] = 1700000000000000ULL + (generator() & 0xfffff);
+        signed_values[i] = int64_t(generator() % 200000) - 100000;
+    }
+
+    check("radix_sort, 24 bit values in uint64_t", call_radix_sort<uint64_t>, small_values);
+    check("radix_sort, 16 bits from bit 4 in uint64_t", call_radix_sort<uint64_t>, shifted_values);
+    check("radix_sort, timestamps within 2^20", call_radix_sort<uint64_t>, timestamps);
+    check("radix_sort, int64_t around 0", call_radix_sort<int64_t>, signed_values);
+}
+
+// Sorted, reversed and mostly sorted trades with repeated timestamps: the presorted paths
+// must keep equal timestamps in input order too.
+void check_presorted()
+{
+    vector<Trade> trades(1000000);
+
+    for(size_t i = 0; i < trades.size(); ++i)
+        trades[i] = Trade{ int64_t(i / 4), uint32_t(i) };
+
+    auto by_timestamp = [](vector<Trade> & v)
+    {
+        RadixSort::radix_sort(v.data(), v.size(), [](const Trade & t) { return t.timestamp; });
+    };
+
+    check("radix_sort, sorted trades", by_timestamp, trades);
+
+    reverse(trades.begin(), trades.end());
+
+    for(size_t i = 0; i < trades.size(); ++i)
+        trades[i].row = uint32_t(i);
+
+    check("radix_sort, reversed trades", by_timestamp, trades);
+
+    // A sorted prefix of 80% and a random tail, merged into it.
+    vector<uint64_t> values(1000000);
+
+    generate(values.begin(), values.end(), random_values<uint64_t>());
+    sort(values.begin(), values.begin() + 800000);
+
+    check("radix_sort, sorted prefix", call_radix_sort<uint64_t>, values);
+
+    check("radix_sort_append", [](vector<uint64_t> & v)
+    {
+        RadixSort::radix_sort_append(v.data(), v.size(), 800000);
+    }, values);
+}
+
+// radix_sort with SortStats sorts as before and counts the passes: 24 bit values in
+// uint64_t take 3 passes and skip the other 5 bytes.
+void check_stats()
+{
+    mt19937_64 generator(1);
+
+    vector<uint64_t> values(1000000);
+
+    for(uint64_t & value : values)
+        value = generator() & 0xffffff;
+
+    RadixSort::SortStats stats;
+
+    check("radix_sort with SortStats", [&stats](vector<uint64_t> & v)
+    {
+        RadixSort::radix_sort(v.data(), v.size(), stats);
+    }, values);
+
+    if(stats.num_passes != 3 || stats.skipped_passes != 5)
+    {
+        cout << "radix_sort with SortStats: " << stats.num_passes << " passes run and " <<
+             stats.skipped_passes << " skipped instead of 3 and 5" << endl;
+        exit(1);
+    }
+
+    cout << "SortStats, passes run and skipped | OK" << endl;
+}
+
+// 8 and 16 bit keys are sorted by counting; radix_sort_counting does the same for a known range.
+void check_counting()
+{
+    vector<uint16_t> unsigned_values(1000000);
+    vector<int16_t> signed_values(1000000);
+
+    generate(unsigned_values.begin(), unsigned_values.end(), random_values<uint16_t>());
+    generate(signed_values.begin(), signed_values.end(), random_values<int16_t>());
+
+    check("radix_sort, counting, uint16_t", call_radix_sort<uint16_t>, unsigned_values);
+    check("radix_sort, counting, int16_t", call_radix_sort<int16_t>, signed_values);
+
+    // Three values, so the write fills long runs.
+    vector<uint8_t> bytes(1000000);
+
+    for(size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] = uint8_t(i % 3 * 100);
+
+    check("radix_sort, counting, uint8_t with long runs", call_radix_sort<uint8_t>, bytes);
+
+    vector<int64_t> days(1000000);
+
+    for(size_t i = 0; i < days.size(); ++i)
+        days[i] = int64_t(unsigned_values[i] % 1000) - 500;
+
+    check("radix_sort_counting, int64_t in [-500, 499]", [](vector<int64_t> & v)
+    {
+        RadixSort::radix_sort_counting(v.data(), v.size(), int64_t(-500), int64_t(499));
+    }, days);
+}
+
+// Rows of (date, account, amount, row number) in tuples. The account is stored inverted, so
+// that std::stable_sort of the tuples sorts by date, account descending, amount and row.
+typedef tuple<int32_t, uint32_t, float, uint32_t> TableRow;
+
+struct Table
+{
+    vector<int32_t> date;
+    vector<uint32_t> account;
+    vector<float> amount;
+    vector<uint32_t> row;
+
+    explicit Table(const vector<TableRow> & rows)
+    {
+        for(const TableRow & r : rows)
+        {
+            date.push_back(get<0>(r));
+            account.push_back(~get<1>(r));
+            amount.push_back(get<2>(r));
+            row.push_back(get<3>(r));
+        }
+    }
+
+    TableRow operator[](size_t i) const
+    {
+        return TableRow(date[i], ~account[i], amount[i], row[i]);
+    }
+};
+
+void check_columns()
+{
+    mt19937 generator(1);
+
+    vector<TableRow> rows(1000000);
+
+    for(size_t i = 0; i < rows.size(); ++i)
+        rows[i] = TableRow(int32_t(generator() % 30) - 15, ~uint32_t(generator() % 50),
+                           float(int(generator() % 100) - 50), uint32_t(i));
+
+    check("radix_argsort_columns", [](vector<TableRow> & v)
+    {
+        Table table(v);
+        vector<uint32_t> indices(v.size());
+
+        RadixSort::SortColumn columns[] = { RadixSort::sort_column(table.date.data()),
+                                            RadixSort::sort_column(table.account.data(), RadixSort::SortOrder::descending),
+                                            RadixSort::sort_column(table.amount.data()) };
+
+        RadixSort::radix_argsort_columns(columns, 3, v.size(), indices.data());
+
+        for(size_t i = 0; i < v.size(); ++i)
+            v[i] = table[indices[i]];
+    }, rows);
+
+    // The row numbers are sorted as a fourth column, so they show that every column moved together.
+    check("radix_sort_columns", [](vector<TableRow> & v)
+    {
+        Table table(v);
+
+        RadixSort::SortColumn columns[] = { RadixSort::sort_column(table.date.data()),
+                                            RadixSort::sort_column(table.account.data(), RadixSort::SortOrder::descending),
+                                            RadixSort::sort_column(table.amount.data()),
+                                            RadixSort::sort_column(table.row.data()) };
+
+        RadixSort::radix_sort_columns(columns, 4, v.size());
+
+        for(size_t i = 0; i < v.size(); ++i)
+            v[i] = table[i];
+    }, rows);
+}
+
+// Values under 1000 in absolute value, so most of them repeat. The distinct values, their
+// counts and the group offsets are compared with std::unique and a scan of the sorted array.
+template <typename T>
+void check_unique()
+{
+    vector<T> values(1000000);
+
+    random_values<T> random_value;
+
+    for(T & value : values)
+        value = T(random_value() % 1000);
+
+    vector<T> sorted = values;
+
+    std::sort(sorted.begin(), sorted.end());
+
+    vector<T> distinct = sorted;
+
+    distinct.erase(unique(distinct.begin(), distinct.end()), distinct.end());
+
+    vector<size_t> offsets;
+
+    for(size_t i = 0; i < sorted.size(); ++i)
+        if(i == 0 || sorted[i] != sorted[i - 1])
+            offsets.push_back(i);
+
+    offsets.push_back(sorted.size());
+
+    vector<size_t> counts(distinct.size());
+
+    for(size_t k = 0; k < counts.size(); ++k)
+        counts[k] = offsets[k + 1] - offsets[k];
+
+    const string type_name = TypeData<T>::name;
+
+    vector<T> unique_values = values;
+    unique_values.resize(RadixSort::radix_sort_unique(unique_values.data(), unique_values.size()));
+
+    check_equal("radix_sort_unique, " + type_name, unique_values, distinct);
+
+    vector<T> rle_values = values;
+    vector<size_t> rle_counts(values.size());
+
+    const size_t runs = RadixSort::radix_sort_rle(rle_values.data(), rle_values.size(), rle_counts.data());
+
+    rle_values.resize(runs);
+    rle_counts.resize(runs);
+
+    check_equal("radix_sort_rle, values, " + type_name, rle_values, distinct);
+    check_equal("radix_sort_rle, counts, " + type_name, rle_counts, counts);
+
+    vector<T> grouped = values;
+    vector<size_t> group_offsets(values.size() + 1);
+
+    group_offsets.resize(RadixSort::radix_sort_group_offsets(grouped.data(), grouped.size(), group_offsets.data()) + 1);
+
+    check_equal("radix_sort_group_offsets, values, " + type_name, grouped, sorted);
+    check_equal("radix_sort_group_offsets, offsets, " + type_name, group_offsets, offsets);
+}
+
+// 48 MB arrays, above the 32 MB from which radix_sort_hybrid makes its MSD pass.
+void check_hybrid()
+{
+    vector<uint64_t> values(6000000);
+
+    generate(values.begin(), values.end(), random_values<uint64_t>());
+
+    check("radix_sort_hybrid, uint64_t", [](vector<uint64_t> & v)
+    {
+        RadixSort::radix_sort_hybrid(v.data(), v.size());
+    }, values);
+
+    check("radix_sort_hybrid, 4 threads, uint64_t", [](vector<uint64_t> & v)
+    {
+        RadixSort::radix_sort_hybrid(v.data(), v.size(), size_t(4));
+    }, values);
+
+    // Most keys in one bucket of the first pass, which is split again by the next byte.
+    vector<int64_t> skewed(values.size());
+
+    for(size_t i = 0; i < skewed.size(); ++i)
+        skewed[i] = i % 10 == 0 ? int64_t(values[i]) : int64_t(values[i] >> 24);
+
+    check("radix_sort_hybrid, skewed int64_t", [](vector<int64_t> & v)
+    {
+        RadixSort::radix_sort_hybrid(v.data(), v.size());
+    }, skewed);
+}
+
+// A sorted column of 900000 values with 100000 new ones appended.
+void check_append_parallel()
+{
+    vector<int64_t> values(1000000);
+
+    generate(values.begin(), values.end(), random_values<int64_t>());
+    sort(values.begin(), values.begin() + 900000);
+
+    check("radix_sort_append_parallel, 4 threads", [](vector<int64_t> & v)
+    {
+        RadixSort::radix_sort_append_parallel(v.data(), v.size(), 900000, 4);
+    }, values);
+
+    check("radix_sort_append_parallel with a buffer, 4 threads", [](vector<int64_t> & v)
+    {
+        vector<int64_t> temp(v.size());
+        RadixSort::radix_sort_append_parallel(v.data(), v.size(), 900000, temp.data(), 4);
+    }, values);
+
+    RadixSort::Workspace workspace;
+
+    check("radix_sort_append_parallel with a Workspace, 4 threads", [&workspace](vector<int64_t> & v)
+    {
+        RadixSort::radix_sort_append_parallel(v.data(), v.size(), 900000, workspace, 4);
+    }, values);
+}
+
+template <unsigned DigitBits, typename T>
+void check_digit_width()
+{
+    vector<T> values(1000000);
+
+    generate(values.begin(), values.end(), random_values<T>());
+
+    check("radix_sort<" + to_string(DigitBits) + ">, " + TypeData<T>::name, [](vector<T> & v)
+    {
+        RadixSort::radix_sort<DigitBits>(v.data(), v.size());
+    }, values);
+}
+
+// IEEE 754 totalOrder as an unsigned key: negative numbers reversed, below the positive ones.
+template <typename UInt>
+UInt total_order_key(UInt bits)
+{
+    const UInt sign = UInt(1) << (sizeof(UInt) * 8 - 1);
+
+    return bits & sign ? UInt(~bits) : UInt(bits | sign);
+}
+
+template <typename UInt>
+bool total_order_less(UInt a, UInt b)
+{
+    return total_order_key(a) < total_order_key(b);
+}
+
+vector<uint64_t> double_bits(const vector<double> & values)
+{
+    vector<uint64_t> bits(values.size());
+
+    memcpy(bits.data(), values.data(), values.size() * sizeof(double));
+
+    return bits;
+}
+
+// Doubles with both zeros, infinities, subnormals and NaNs, compared bit for bit. nans_last
+// must match std::stable_sort of the numbers followed by the NaNs in input order, total_order
+// std::stable_sort by the totalOrder key. 16 bit floats are checked on every bit pattern.
+void check_floats()
+{
+    mt19937_64 generator(1);
+    normal_distribution<double> distribution(0, 1000);
+
+    vector<double> values(1000000);
+
+    for(size_t i = 0; i < values.size(); ++i)
+    {
+        switch(i % 50)
+        {
+        case 0: values[i] = 0.0; break;
+        case 1: values[i] = -0.0; break;
+        case 2: values[i] = numeric_limits<double>::infinity(); break;
+        case 3: values[i] = -numeric_limits<double>::infinity(); break;
+        case 4: values[i] = numeric_limits<double>::quiet_NaN(); break;
+        case 5: values[i] = -numeric_limits<double>::quiet_NaN(); break;
+        case 6: values[i] = numeric_limits<double>::denorm_min() * double(i); break;
+        default: values[i] = distribution(generator);
+        }
+    }
+
+    vector<double> numbers_first = values;
+
+    auto numbers_end = stable_partition(numbers_first.begin(), numbers_first.end(), [](double x) { return !std::isnan(x); });
+    std::stable_sort(numbers_first.begin(), numbers_end);
+
+    vector<double> nans_last = values;
+    RadixSort::radix_sort(nans_last.data(), nans_last.size(), RadixSort::FloatOrder::nans_last);
+
+    check_equal("radix_sort, double, FloatOrder::nans_last", double_bits(nans_last), double_bits(numbers_first));
+
+    vector<uint64_t> total_order = double_bits(values);
+    std::stable_sort(total_order.begin(), total_order.end(), total_order_less<uint64_t>);
+
+    vector<double> sorted = values;
+    RadixSort::radix_sort(sorted.data(), sorted.size());
+
+    check_equal("radix_sort, double, FloatOrder::total_order", double_bits(sorted), total_order);
+
+    vector<uint16_t> halves(1 << 16);
+
+    for(size_t i = 0; i < halves.size(); ++i)
+        halves[i] = uint16_t(i * 40503);
+
+    vector<uint16_t> halves_sorted = halves;
+    std::stable_sort(halves_sorted.begin(), halves_sorted.end(), total_order_less<uint16_t>);
+
+    vector<uint16_t> float16 = halves;
+    RadixSort::radix_sort_float16(float16.data(), float16.size());
+
+    check_equal("radix_sort_float16", float16, halves_sorted);
+
+    vector<uint16_t> bfloat16 = halves;
+    RadixSort::radix_sort_bfloat16(bfloat16.data(), bfloat16.size());
+
+    check_equal("radix_sort_bfloat16", bfloat16, halves_sorted);
+}
+
+void check_strings()
+{
+    mt19937 generator(1);
+
+    vector<string> words(100000);
+
+    for(string & word : words)
+    {
+        word.resize(generator() % 12);
+
+        for(char & c : word)
+            c = char('a' + generator() % 4);
+    }
+
+    check("radix_sort_strings, short words", [](vector<string> & v)
+    {
+        RadixSort::radix_sort_strings(v.data(), v.size());
+    }, words);
+
+    // Every string shares a prefix with all longer ones, so the sort goes 4000 levels deep.
+    vector<string> prefixes;
+
+    for(unsigned i = 0; i < 4000; ++i)
+        prefixes.push_back(string(i, 'x') + "y");
+
+    shuffle(prefixes.begin(), prefixes.end(), generator);
+
+    check("radix_sort_strings, long shared prefixes", [](vector<string> & v)
+    {
+        RadixSort::radix_sort_strings(v.data(), v.size());
+    }, prefixes);
+}
+
+template <typename T>
+void call_radix_sort_array(vector<T> & v)
+{
+    RadixSort::radix_sort(v.data(), v.size());
+}
+
+void check_wide_keys()
+{
+    mt19937_64 generator(1);
+
+#ifdef RADIX_SORT_HAS_INT128
+    vector<unsigned __int128> unsigned_keys(1000000);
+
+    for(unsigned __int128 & key : unsigned_keys)
+        key = (unsigned __int128)generator() << 64 | generator();
+
+    check("radix_sort, unsigned __int128", call_radix_sort_array<unsigned __int128>, unsigned_keys);
+
+    vector<__int128> signed_keys(unsigned_keys.begin(), unsigned_keys.end());
+
+    check("radix_sort, __int128", call_radix_sort_array<__int128>, signed_keys);
+#endif
+
+    // UUIDs, half of them with the same first 8 bytes.
+    vector<array<uint8_t, 16>> uuids(1000000);
+
+    for(array<uint8_t, 16> & uuid : uuids)
+        for(uint8_t & byte : uuid)
+            byte = uint8_t(generator());
+
+    for(size_t i = 0; i < uuids.size(); i += 2)
+        fill(uuids[i].begin(), uuids[i].begin() + 8, 0);
+
+    check("radix_sort, array<uint8_t, 16>", call_radix_sort_array<array<uint8_t, 16>>, uuids);
+
+    // 4 KiB keys where key i starts with i ones: each byte splits off one key, so the sort goes 3000 levels deep.
+    vector<array<uint8_t, 4096>> pages(3000);
+
+    for(size_t i = 0; i < pages.size(); ++i)
+    {
+        pages[i].fill(0);
+        fill(pages[i].begin(), pages[i].begin() + i, 1);
+    }
+
+    shuffle(pages.begin(), pages.end(), generator);
+
+    check("radix_sort, array<uint8_t, 4096>", call_radix_sort_array<array<uint8_t, 4096>>, pages);
+}
+
+// A record too large and not trivially copyable to be moved by every pass: sorted by key
+// projection it goes through (key, index) pairs. std::stable_sort orders it by timestamp.
+struct Record
+{
+    uint64_t timestamp;
+    string name;
+    string payload;
+};
+
+bool operator<(const Record & a, const Record & b)
+{
+    return a.timestamp < b.timestamp;
+}
+
+bool operator==(const Record & a, const Record & b)
+{
+    return a.timestamp == b.timestamp && a.name == b.name && a.payload == b.payload;
+}
+
+bool operator!=(const Record & a, const Record & b)
+{
+    return !(a == b);
+}
+
+uint64_t record_timestamp(const Record & record)
+{
+    return record.timestamp;
+}
+
+void check_records()
+{
+    mt19937_64 generator(1);
+
+    vector<Record> records(100000);
+
+    for(Record & record : records)
+    {
+        record.timestamp = generator() % 1000;
+        record.name = string(generator() % 40, 'n');
+        record.payload = to_string(generator());
+    }
+
+    check("radix_sort, records by key", [](vector<Record> & v)
+    {
+        RadixSort::radix_sort(v.data(), v.size(), record_timestamp);
+    }, records);
+
+    RadixSort::Workspace workspace;
+
+    check("radix_sort with a Workspace, records by key", [&workspace](vector<Record> & v)
+    {
+        RadixSort::radix_sort(v.data(), v.size(), workspace, record_timestamp);
+    }, records);
+
+    check("radix_sort_indirect, records by key", [](vector<Record> & v)
+    {
+        RadixSort::radix_sort_indirect(v.data(), v.size(), record_timestamp);
+    }, records);
+
+    check("radix_sort_indirect_copy, records by key", [](vector<Record> & v)
+    {
+        vector<Record> out(v.size());
+        RadixSort::radix_sort_indirect_copy(v.data(), v.size(), out.data(), record_timestamp);
+        v.swap(out);
+    }, records);
+}
+
+// Writes values to a file, sorts it with radix_sort_file and reads it back.
+// 64 KiB of memory splits a million int64_t values into 245 runs.
+void sort_file(vector<int64_t> & values)
+{
+    const char* path = "radix_sort_check.bin";
+
+    ofstream(path, ios::binary).write((const char*)values.data(), values.size() * sizeof(int64_t));
+
+    if(!RadixSort::radix_sort_file<int64_t>(path, path, 1 << 16))
+    {
+        cout << "radix_sort_file: can't sort " << path << endl;
+        exit(1);
+    }
+
+    ifstream(path, ios::binary).read((char*)values.data(), values.size() * sizeof(int64_t));
+
+    remove(path);
+}
+
+void check_file()
+{
+    vector<int64_t> values(1000000);
+
+    generate(values.begin(), values.end(), random_values<int64_t>());
+
+    check("radix_sort_file", sort_file, values);
+}
+
+// Keys with 4096 distinct values, so that partitions hold runs of equal keys.
+vector<uint32_t> clustered_keys(size_t size)
+{
+    vector<uint32_t> keys(size);
+
+    generate(keys.begin(), keys.end(), random_values<uint32_t>());
+
+    for(uint32_t & key : keys)
+        key &= 0xff00000f;
+
+    return keys;
+}
+
+// radix_partition by the top 8 bits of the keys. Partition p holds the keys whose top bits
+// are p, in input order, so sorting every partition by key with std::stable_sort must give
+// the whole array sorted; with the row numbers as payload, sorted by key and then row.
+void check_partition()
+{
+    const vector<uint32_t> keys = clustered_keys(1000000);
+
+    check("radix_partition, keys", [](vector<uint32_t> & v)
+    {
+        vector<uint32_t> out(v.size());
+        vector<size_t> offsets(257);
+
+        RadixSort::radix_partition(v.data(), v.size(), 24, 8, out.data(), offsets.data());
+
+        for(size_t p = 0; p < 256; ++p)
+            std::stable_sort(out.begin() + offsets[p], out.begin() + offsets[p + 1]);
+
+        v.swap(out);
+    }, keys);
+
+    vector<pair<uint32_t, uint32_t>> rows(keys.size());
+
+    for(size_t i = 0; i < rows.size(); ++i)
+        rows[i] = make_pair(keys[i], uint32_t(i));
+
+    check("radix_partition, keys and payload, 4 threads", [](vector<pair<uint32_t, uint32_t>> & v)
+    {
+        vector<uint32_t> keys(v.size()), rows(v.size()), keys_out(v.size()), rows_out(v.size());
+        vector<size_t> offsets(257);
+
+        for(size_t i = 0; i < v.size(); ++i)
+        {
+            keys[i] = v[i].first;
+            rows[i] = v[i].second;
+        }
+
+        RadixSort::radix_partition(keys.data(), rows.data(), v.size(), 24, 8, keys_out.data(), rows_out.data(),
+                                   offsets.data(), 4);
+
+        for(size_t i = 0; i < v.size(); ++i)
+            v[i] = make_pair(keys_out[i], rows_out[i]);
+
+        for(size_t p = 0; p < 256; ++p)
+            std::stable_sort(v.begin() + offsets[p], v.begin() + offsets[p + 1],
+                             [](const pair<uint32_t, uint32_t> & a, const pair<uint32_t, uint32_t> & b)
+                             {
+                                 return a.first < b.first;
+                             });
+    }, rows);
+
+    vector<uint32_t> out(keys.size());
+    vector<size_t> offsets(257);
+
+    try
+    {
+        RadixSort::radix_partition(keys.data(), keys.size(), 28, 8, out.data(), offsets.data());
+
+        cout << "radix_partition: bits past the key width were not rejected" << endl;
+        exit(1);
+    }
+    catch(const invalid_argument &)
+    {
+        cout << "radix_partition, bits past the key width | OK" << endl;
+    }
+}
 
 template <typename T>
 void run_test(const unsigned number_of_elements)
@@ -151,6 +1053,45 @@ void run_tests(const unsigned number_of_elements)
 
 int main()
 {
+    check_parallel<uint16_t>();
+    check_parallel<int32_t>();
+    check_parallel<int64_t>();
+    check_parallel<float>();
+    check_by_key<uint8_t>();
+    check_by_key<int32_t>();
+    check_by_key<uint64_t>();
+    check_digit_width<11, uint32_t>();
+    check_digit_width<11, int64_t>();
+    check_digit_width<16, float>();
+    check_in_place<int8_t>();
+    check_in_place<int16_t>();
+    check_in_place<uint32_t>();
+    check_in_place<int64_t>();
+    check_in_place<double>();
+    check_projection();
+    check_segmented();
+    check_workspace();
+    check_pass_planning();
+    check_presorted();
+    check_stats();
+    check_counting();
+    check_columns();
+    check_unique<uint16_t>();
+    check_unique<int32_t>();
+    check_unique<uint64_t>();
+    check_hybrid();
+    check_append_parallel();
+    check_floats();
+    check_strings();
+    check_wide_keys();
+    check_records();
+    check_selection<uint8_t>();
+    check_selection<int8_t>();
+    check_selection<double>();
+    check_file();
+    check_partition();
+    cout << endl;
+
     const unsigned num_of_elements = 50000000U;
 
     cout << "Number of elements: " << num_of_elements << endl;
@@ -163,6 +1104,7 @@ int main()
             uint32_t,
             int64_t,
             uint64_t,
-            float
+            float,
+            double
             >(num_of_elements);
 }
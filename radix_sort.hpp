@@ -1,6 +1,48 @@
 #include <cstdint>
 #include <limits>
 #include <climits>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <new>
+#include <stdexcept>
+#include <chrono>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define RADIX_SORT_HAS_MMAP
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#define RADIX_SORT_HAS_PERF_EVENT
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RADIX_SORT_HAS_SSE2
+#endif
+
+#ifdef __SIZEOF_INT128__
+#define RADIX_SORT_HAS_INT128
+#endif
+
+#ifdef __FLT16_MANT_DIG__
+#define RADIX_SORT_HAS_FLOAT16
+#endif
+
+#ifdef __STDCPP_BFLOAT16_T__
+#include <stdfloat>
+#define RADIX_SORT_HAS_BFLOAT16
+#endif
 
 #ifndef RADIX_SORT_H
 #define RADIX_SORT_H
@@ -17,9 +59,9 @@ inline size_t byte(T value)
 }
 
 template<typename T, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
-void copy_with_reordering(T* array, T* array_end, T* temp, size_t size, size_t* freq, 
-                          ExtractByteFuncT extract_byte_f, 
-                          BitwiseTransformFuncT bitwise_transform_f)
+void copy_with_reordering_direct(T* array, T* array_end, T* temp, size_t size, size_t* freq, 
+                                 ExtractByteFuncT extract_byte_f, 
+                                 BitwiseTransformFuncT bitwise_transform_f)
 {
     size_t unroll_size = size >> 2;
 
@@ -45,6 +87,133 @@ void copy_with_reordering(T* array, T* array_end, T* temp, size_t size, size_t*
     }
 }
 
+const size_t cache_line_size = 64;
+
+// Passes that move at least this many bytes go through write-combining buffers.
+// Below it the destination buckets stay cache resident and direct stores are faster.
+const size_t write_combining_threshold = size_t(1) << 22;
+
+// Buckets with more digits than this would not fit their staging buffers in L2.
+const size_t write_combining_max_buckets = 2048;
+
+template<typename T, size_t Buckets>
+struct supports_write_combining : std::integral_constant<bool,
+    Buckets <= write_combining_max_buckets &&
+    std::is_trivially_copyable<T>::value &&
+    sizeof(T) <= cache_line_size &&
+    cache_line_size % sizeof(T) == 0 &&
+    alignof(T) == sizeof(T)>
+{
+};
+
+// Writes one full, cache line aligned line, bypassing the cache where possible.
+inline void stream_cache_line(void* dst, const void* src)
+{
+#ifdef RADIX_SORT_HAS_SSE2
+    const __m128i* s = static_cast<const __m128i*>(src);
+    __m128i* d = static_cast<__m128i*>(dst);
+
+    _mm_stream_si128(d, _mm_load_si128(s));
+    _mm_stream_si128(d + 1, _mm_load_si128(s + 1));
+    _mm_stream_si128(d + 2, _mm_load_si128(s + 2));
+    _mm_stream_si128(d + 3, _mm_load_si128(s + 3));
+#else
+    std::memcpy(dst, src, cache_line_size);
+#endif
+}
+
+// Same result as copy_with_reordering_direct, but elements are first staged in a
+// cache line sized buffer per bucket, and only whole lines are written to temp.
+// This keeps 256 write streams from thrashing the cache and the TLB on large arrays.
+template<size_t Buckets, typename T, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
+void copy_with_reordering_buffered(T* array, T* array_end, T* temp, size_t* freq,
+                                   ExtractByteFuncT extract_byte_f,
+                                   BitwiseTransformFuncT bitwise_transform_f)
+{
+    const size_t line = cache_line_size / sizeof(T);
+
+    alignas(cache_line_size) unsigned char storage[Buckets * cache_line_size];
+    T* buffer = reinterpret_cast<T*>(storage);
+
+    size_t fill[Buckets] = { 0 };
+
+    for (T* p = array; p != array_end; ++p)
+    {
+        size_t b = extract_byte_f(bitwise_transform_f(*p));
+        T* slot = buffer + b * line;
+
+        slot[fill[b]++] = *p;
+
+        T* end = temp + freq[b] + fill[b];
+
+        // Flush when the staged run reaches a line boundary in temp. The first flush
+        // of a bucket may be partial, after that every flush is a full aligned line.
+        if ((reinterpret_cast<uintptr_t>(end) & (cache_line_size - 1)) == 0)
+        {
+            if (fill[b] == line)
+                stream_cache_line(temp + freq[b], slot);
+            else
+                std::memcpy(temp + freq[b], slot, fill[b] * sizeof(T));
+
+            freq[b] += fill[b];
+            fill[b] = 0;
+        }
+    }
+
+    for (size_t b = 0; b < Buckets; ++b)
+    {
+        std::memcpy(temp + freq[b], buffer + b * line, fill[b] * sizeof(T));
+        freq[b] += fill[b];
+    }
+
+#ifdef RADIX_SORT_HAS_SSE2
+    _mm_sfence();
+#endif
+}
+
+template<size_t Buckets, typename T, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
+void copy_with_reordering(T* array, T* array_end, T* temp, size_t size, size_t* freq,
+                          ExtractByteFuncT extract_byte_f,
+                          BitwiseTransformFuncT bitwise_transform_f,
+                          std::true_type /* supports write combining */)
+{
+    if (size * sizeof(T) >= write_combining_threshold)
+        copy_with_reordering_buffered<Buckets>(array, array_end, temp, freq, extract_byte_f, bitwise_transform_f);
+    else
+        copy_with_reordering_direct(array, array_end, temp, size, freq, extract_byte_f, bitwise_transform_f);
+}
+
+template<size_t Buckets, typename T, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
+void copy_with_reordering(T* array, T* array_end, T* temp, size_t size, size_t* freq,
+                          ExtractByteFuncT extract_byte_f,
+                          BitwiseTransformFuncT bitwise_transform_f,
+                          std::false_type /* supports write combining */)
+{
+    copy_with_reordering_direct(array, array_end, temp, size, freq, extract_byte_f, bitwise_transform_f);
+}
+
+// Buckets is the number of distinct values extract_byte_f can return.
+template<size_t Buckets = 256, typename T, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
+void copy_with_reordering(T* array, T* array_end, T* temp, size_t size, size_t* freq,
+                          ExtractByteFuncT extract_byte_f,
+                          BitwiseTransformFuncT bitwise_transform_f)
+{
+    copy_with_reordering<Buckets>(array, array_end, temp, size, freq, extract_byte_f, bitwise_transform_f,
+                                  supports_write_combining<T, Buckets>());
+}
+
+inline void radix_sort_calculate_offset_table_8(size_t* freq_0)
+{
+    size_t offset_0 = 0;
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        size_t temp_offset = freq_0[i] + offset_0;
+        freq_0[i] = offset_0;
+        offset_0 = temp_offset;
+    }
+}
+
 void radix_sort_calculate_offset_table_16(size_t* freq_0, size_t* freq_1)
 {
     size_t offset_0 = 0;
@@ -308,20 +477,372 @@ void radix_sort_calculate_offset_table_64(size_t* freq_0, size_t* freq_1,
     }
 }
 
+// Number of interleaved sub-histograms per digit used by radix_sort_histogram_interleaved.
+const size_t histogram_interleave = 4;
+
+// Inputs with at least this many elements count into interleaved sub-histograms.
+const size_t interleaved_histogram_threshold = size_t(1) << 14;
+
+// Counts num_digits byte histograms like radix_sort_histogram_{16,32,64}, but consecutive
+// elements go to histogram_interleave separate 32 bit sub-histograms that are summed at the end.
+// When the same byte value repeats (sorted, low cardinality or small range data), the
+// increments no longer form a single chain of dependent read-modify-writes on one counter,
+// which otherwise stalls on store-to-load forwarding.
+template <unsigned num_digits, typename T, typename F>
+void radix_sort_histogram_interleaved(const T* array, size_t size, size_t (*frequencies)[256],
+                                      F bitwise_transform)
+{
+    // Every sub-histogram counts at most block_size / histogram_interleave elements per block,
+    // which keeps the 32 bit counters from overflowing.
+    const size_t block_size = size_t(1) << 31;
+
+    uint32_t sub_frequencies[histogram_interleave][num_digits][256];
+
+    const T* p = array;
+    const T* array_end = array + size;
+
+    while (size_t(array_end - p) >= histogram_interleave)
+    {
+        std::memset(sub_frequencies, 0, sizeof(sub_frequencies));
+
+        size_t unroll_size = std::min(size_t(array_end - p), block_size) / histogram_interleave;
+
+        for (; unroll_size; --unroll_size, p += histogram_interleave)
+        {
+            for (size_t j = 0; j < histogram_interleave; ++j)
+            {
+                auto element = bitwise_transform(*(p + j));
+
+                for (unsigned d = 0; d < num_digits; ++d)
+                    sub_frequencies[j][d][(element >> (d * CHAR_BIT)) & 255]++;
+            }
+        }
+
+        for (unsigned d = 0; d < num_digits; ++d)
+            for (size_t j = 0; j < histogram_interleave; ++j)
+                for (size_t i = 0; i < 256; ++i)
+                    frequencies[d][i] += sub_frequencies[j][d][i];
+    }
+
+    for (; p != array_end; ++p)
+    {
+        auto element = bitwise_transform(*p);
+
+        for (unsigned d = 0; d < num_digits; ++d)
+            frequencies[d][(element >> (d * CHAR_BIT)) & 255]++;
+    }
+}
+
+// Phases of a byte radix sort, as reported to an instrumentation policy.
+enum class SortPhase
+{
+    insertion_sort,
+    presorted_check,
+    histogram,
+    planning,
+    pass,
+    copy_back,
+    merge
+};
+
+// Instrumentation policy of the byte engines: begin() is called when a phase starts and
+// end(phase, bytes, pass) when it ends, with the bytes of elements it read and wrote and
+// for SortPhase::pass the pass number; skipped_passes(n) reports key bytes that took no
+// pass. Phases don't nest. The policy is passed by value, a policy that keeps results
+// must keep them behind a pointer. This one does nothing and compiles away.
+struct no_instrumentation
+{
+    void begin() {}
+    void end(SortPhase, size_t, unsigned = 0) {}
+    void skipped_passes(unsigned) {}
+};
+
+// Arrays shorter than this are insertion sorted instead: below it, clearing the
+// histograms and building the offset tables costs more than the sort itself.
+// Measured crossover points for 2, 4 and 8 byte keys.
+constexpr size_t small_sort_threshold(size_t key_size)
+{
+    return key_size <= 2 ? 24 : key_size <= 4 ? 48 : 64;
+}
+
+// Stable insertion sort by transformed key.
 template <typename T, typename F>
-void radix_sort_16_impl(T* array, size_t size, T* temp, F bitwise_transform)
+void insertion_sort(T* array, size_t size, F bitwise_transform)
 {
-    size_t frequencies[2][256] = { 0 };
+    for (size_t i = 1; i < size; ++i)
+    {
+        T value = array[i];
+        auto key = bitwise_transform(value);
+
+        size_t j = i;
+
+        for (; j > 0 && key < bitwise_transform(array[j - 1]); --j)
+            array[j] = array[j - 1];
+
+        array[j] = value;
+    }
+}
+
+// Length of the longest non-decreasing prefix of array. If the whole array is
+// non-increasing instead, reverses it first (keeping equal elements in their input
+// order) and returns size. Stops at the first element out of order, so on unsorted
+// input it looks at a couple of elements only. size must not be 0.
+template <typename T, typename F>
+size_t presorted_prefix(T* array, size_t size, F bitwise_transform)
+{
+    size_t sorted = 1;
+
+    while (sorted < size && !(bitwise_transform(array[sorted]) < bitwise_transform(array[sorted - 1])))
+        ++sorted;
+
+    // A non-increasing array can only start with a run of equal elements.
+    if (sorted == size || bitwise_transform(array[sorted - 1]) != bitwise_transform(array[0]))
+        return sorted;
+
+    size_t reversed = sorted;
+
+    while (reversed < size && !(bitwise_transform(array[reversed - 1]) < bitwise_transform(array[reversed])))
+        ++reversed;
+
+    if (reversed != size)
+        return sorted;
+
+    std::reverse(array, array + size);
+
+    // Runs of equal elements are now backwards, restore their order.
+    for (size_t begin = 0; begin < size;)
+    {
+        auto key = bitwise_transform(array[begin]);
+
+        size_t end = begin + 1;
+
+        while (end < size && bitwise_transform(array[end]) == key)
+            ++end;
+
+        std::reverse(array + begin, array + end);
+        begin = end;
+    }
+
+    return size;
+}
+
+// Merges the sorted tail array[sorted, size) into the sorted prefix array[0, sorted),
+// from the back, so that only the tail has to be copied out. temp must hold size - sorted
+// elements. Stable: prefix elements stay ahead of equal tail elements.
+template <typename T, typename F>
+void merge_sorted_tail(T* array, size_t size, size_t sorted, T* temp, F bitwise_transform)
+{
+    const size_t tail = size - sorted;
+
+    std::copy(array + sorted, array + size, temp);
+
+    T* out = array + size;
+    T* left = array + sorted;
+    T* right = temp + tail;
+
+    while (left != array && right != temp)
+    {
+        if (bitwise_transform(*(right - 1)) < bitwise_transform(*(left - 1)))
+            *--out = *--left;
+        else
+            *--out = *--right;
+    }
+
+    std::copy(temp, right, array);
+}
+
+// When the sorted prefix leaves at most this fraction of the array, the byte engines
+// sort just the tail and merge it in.
+const size_t append_tail_fraction = 4;
+
+// The planner below recounts shifted digits only for arrays at least this large;
+// for smaller ones the extra counting pass costs about as much as the pass it saves.
+const size_t replan_threshold = size_t(1) << 12;
+
+// Plans the LSD passes of a byte radix sort, given the raw byte histograms of all
+// num_bytes bytes of the key:
+// - a byte in which every element falls into the same bucket takes no pass;
+// - the bits that differ between elements are read off the histograms (the occupied
+//   buckets of a byte xor the first element's one), and if the bytes they touch take
+//   more passes than their width needs, e.g. 16 significant bits straddling 3 bytes,
+//   the digits are recounted as 8 bit digits starting at the lowest significant bit,
+//   when that saves more than the recount costs.
+// Returns the number of passes; pass i sorts by the 8 bits at shifts[i] with
+// frequencies[i], which is turned into its offset table.
+template <size_t num_bytes, typename T, typename F, typename Instrument>
+unsigned radix_sort_plan_passes(T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform,
+                                unsigned* shifts, Instrument instrument)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    instrument.begin();
+
+    const Ret first = bitwise_transform(array[0]);
+
+    Ret varying = 0;
+    unsigned num_passes = 0;
+
+    for (unsigned i = 0; i < num_bytes; ++i)
+    {
+        const unsigned shift = i * CHAR_BIT;
+        const size_t first_bucket = (first >> shift) & 255;
+
+        if (frequencies[i][first_bucket] == size)
+            continue;
+
+        for (size_t bucket = 0; bucket < 256; ++bucket)
+        {
+            if (frequencies[i][bucket])
+                varying |= Ret(Ret(bucket ^ first_bucket) << shift);
+        }
+
+        shifts[num_passes++] = shift;
+    }
+
+    // All elements are equal.
+    if (num_passes == 0)
+    {
+        instrument.end(SortPhase::planning, 0);
+        instrument.skipped_passes(num_bytes);
+        return 0;
+    }
+
+    unsigned low = 0;
+    unsigned high = num_bytes * CHAR_BIT;
+
+    while (!((varying >> low) & 1))
+        ++low;
+
+    while (!((varying >> (high - 1)) & 1))
+        --high;
+
+    const unsigned needed_passes = (high - low + CHAR_BIT - 1) / CHAR_BIT;
+
+    // An odd number of passes leaves the result in temp and costs a copy back, about
+    // as much as a pass. Recounting costs about as much as a pass too.
+    const unsigned cost = num_passes + num_passes % 2;
+    const unsigned replanned_cost = needed_passes + needed_passes % 2 + 1;
+
+    if (replanned_cost < cost && size >= replan_threshold)
+    {
+        num_passes = needed_passes;
+
+        for (unsigned pass = 0; pass < num_passes; ++pass)
+            shifts[pass] = low + pass * CHAR_BIT;
+
+        auto shifted_transform = [low, &bitwise_transform](const T& v) -> Ret
+        {
+            return Ret(bitwise_transform(v) >> low);
+        };
+
+        instrument.end(SortPhase::planning, 0);
+        instrument.begin();
+
+        std::memset(frequencies, 0, num_bytes * sizeof(frequencies[0]));
+        radix_sort_histogram_interleaved<num_bytes>(array, size, frequencies, shifted_transform);
+
+        instrument.end(SortPhase::histogram, size * sizeof(T));
+        instrument.begin();
+    }
+    else
+    {
+        // Move the histograms of the passes that run to the front.
+        for (unsigned pass = 0; pass < num_passes; ++pass)
+        {
+            if (shifts[pass] != pass * CHAR_BIT)
+                std::copy(frequencies[shifts[pass] / CHAR_BIT], frequencies[shifts[pass] / CHAR_BIT] + 256,
+                          frequencies[pass]);
+        }
+    }
+
+    for (unsigned pass = 0; pass < num_passes; ++pass)
+    {
+        size_t offset = 0;
+
+        for (size_t i = 0; i < 256; ++i)
+        {
+            size_t count = frequencies[pass][i];
+            frequencies[pass][i] = offset;
+            offset += count;
+        }
+    }
+
+    instrument.end(SortPhase::planning, 0);
+    instrument.skipped_passes(unsigned(num_bytes) - num_passes);
+
+    return num_passes;
+}
+
+// Runs the planned LSD passes of a byte radix sort. Passes alternate between array and
+// temp and the result is copied back to array if it ends up in temp.
+template <size_t num_bytes, typename T, typename F, typename Instrument>
+void radix_sort_planned_passes(T* array, size_t size, T* temp, size_t (*frequencies)[256], F bitwise_transform,
+                               Instrument instrument)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    unsigned shifts[num_bytes];
+
+    const unsigned num_passes =
+        radix_sort_plan_passes<num_bytes>(array, size, frequencies, bitwise_transform, shifts, instrument);
+
+    T* src = array;
+    T* dst = temp;
+
+    for (unsigned pass = 0; pass < num_passes; ++pass)
+    {
+        const unsigned shift = shifts[pass];
+
+        auto extract_byte = [shift](Ret v) -> size_t
+        {
+            return (v >> shift) & 255;
+        };
+
+        instrument.begin();
+
+        copy_with_reordering(src, src + size, dst, size, frequencies[pass], extract_byte, bitwise_transform);
+
+        instrument.end(SortPhase::pass, 2 * size * sizeof(T), pass);
+
+        std::swap(src, dst);
+    }
+
+    if (src != array)
+    {
+        instrument.begin();
+        std::copy(src, src + size, array);
+        instrument.end(SortPhase::copy_back, 2 * size * sizeof(T));
+    }
+}
+
+template <typename T, typename F>
+void radix_sort_histogram_8(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform)
+{
+    size_t* freq_0 = frequencies[0];
+
+    const T* array_end = array + size;
+
+    for (const T* p = array; p != array_end; ++p)
+        freq_0[bitwise_transform(*p)]++;
+}
+
+template <typename T, typename F>
+void radix_sort_histogram_16(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform)
+{
+    if (size >= interleaved_histogram_threshold)
+    {
+        radix_sort_histogram_interleaved<2>(array, size, frequencies, bitwise_transform);
+        return;
+    }
 
     size_t* freq_0 = frequencies[0];
     size_t* freq_1 = frequencies[1];
 
-    T* array_end = array + size;
-    T* temp_end = temp + size;
+    const T* array_end = array + size;
 
     size_t unroll_size = size >> 2;
 
-    T* p = array;
+    const T* p = array;
 
     for (; unroll_size; --unroll_size, p += 4)
     {
@@ -350,31 +871,72 @@ void radix_sort_16_impl(T* array, size_t size, T* temp, F bitwise_transform)
         freq_0[byte<0>(h)]++;
         freq_1[byte<1>(h)]++;
     }
+}
+
+template <typename T, typename F, typename Instrument = no_instrumentation>
+void radix_sort_16_impl(T* array, size_t size, T* temp, F bitwise_transform,
+                        Instrument instrument = Instrument())
+{
+    if (size < small_sort_threshold(2))
+    {
+        instrument.begin();
+        insertion_sort(array, size, bitwise_transform);
+        instrument.end(SortPhase::insertion_sort, 2 * size * sizeof(T));
+        return;
+    }
+
+    instrument.begin();
+
+    const size_t sorted = presorted_prefix(array, size, bitwise_transform);
+
+    instrument.end(SortPhase::presorted_check, std::min(sorted + 1, size) * sizeof(T));
+
+    if (sorted == size)
+    {
+        instrument.skipped_passes(2);
+        return;
+    }
 
-    radix_sort_calculate_offset_table_16(freq_0, freq_1);
+    if (size - sorted <= size / append_tail_fraction)
+    {
+        radix_sort_16_impl(array + sorted, size - sorted, temp, bitwise_transform, instrument);
+
+        instrument.begin();
+        merge_sorted_tail(array, size, sorted, temp, bitwise_transform);
+        instrument.end(SortPhase::merge, 2 * (2 * size - sorted) * sizeof(T));
+        return;
+    }
+
+    instrument.begin();
 
-    using Ret = decltype(bitwise_transform(T()));
+    size_t frequencies[2][256] = { 0 };
+
+    radix_sort_histogram_16(array, size, frequencies, bitwise_transform);
 
-    copy_with_reordering(array, array_end, temp, size, freq_0, byte<0, Ret>, bitwise_transform);
-    copy_with_reordering(temp, temp_end, array, size, freq_1, byte<1, Ret>, bitwise_transform);
+    instrument.end(SortPhase::histogram, size * sizeof(T));
+
+    radix_sort_planned_passes<2>(array, size, temp, frequencies, bitwise_transform, instrument);
 }
 
 template <typename T, typename F>
-void radix_sort_32_impl(T* array, size_t size, T* temp, F bitwise_transform)
+void radix_sort_histogram_32(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform)
 {
-    size_t frequencies[4][256] = { 0 };
+    if (size >= interleaved_histogram_threshold)
+    {
+        radix_sort_histogram_interleaved<4>(array, size, frequencies, bitwise_transform);
+        return;
+    }
 
     size_t* freq_0 = frequencies[0];
     size_t* freq_1 = frequencies[1];
     size_t* freq_2 = frequencies[2];
     size_t* freq_3 = frequencies[3];
 
-    T* array_end = array + size;
-    T* temp_end = temp + size;
+    const T* array_end = array + size;
 
     size_t unroll_size = size >> 2;
 
-    T* p = array;
+    const T* p = array;
 
     for (; unroll_size; --unroll_size, p += 4)
     {
@@ -413,21 +975,61 @@ void radix_sort_32_impl(T* array, size_t size, T* temp, F bitwise_transform)
         freq_2[byte<2>(h)]++;
         freq_3[byte<3>(h)]++;
     }
+}
+
+template <typename T, typename F, typename Instrument = no_instrumentation>
+void radix_sort_32_impl(T* array, size_t size, T* temp, F bitwise_transform,
+                        Instrument instrument = Instrument())
+{
+    if (size < small_sort_threshold(4))
+    {
+        instrument.begin();
+        insertion_sort(array, size, bitwise_transform);
+        instrument.end(SortPhase::insertion_sort, 2 * size * sizeof(T));
+        return;
+    }
+
+    instrument.begin();
+
+    const size_t sorted = presorted_prefix(array, size, bitwise_transform);
+
+    instrument.end(SortPhase::presorted_check, std::min(sorted + 1, size) * sizeof(T));
+
+    if (sorted == size)
+    {
+        instrument.skipped_passes(4);
+        return;
+    }
+
+    if (size - sorted <= size / append_tail_fraction)
+    {
+        radix_sort_32_impl(array + sorted, size - sorted, temp, bitwise_transform, instrument);
+
+        instrument.begin();
+        merge_sorted_tail(array, size, sorted, temp, bitwise_transform);
+        instrument.end(SortPhase::merge, 2 * (2 * size - sorted) * sizeof(T));
+        return;
+    }
+
+    instrument.begin();
 
-    radix_sort_calculate_offset_table_32(freq_0, freq_1, freq_2, freq_3);
+    size_t frequencies[4][256] = { 0 };
+
+    radix_sort_histogram_32(array, size, frequencies, bitwise_transform);
 
-    using Ret = decltype(bitwise_transform(T()));
+    instrument.end(SortPhase::histogram, size * sizeof(T));
 
-    copy_with_reordering(array, array_end, temp, size, freq_0, byte<0, Ret>, bitwise_transform);
-    copy_with_reordering(temp, temp_end, array, size, freq_1, byte<1, Ret>, bitwise_transform);
-    copy_with_reordering(array, array_end, temp, size, freq_2, byte<2, Ret>, bitwise_transform);
-    copy_with_reordering(temp, temp_end, array, size, freq_3, byte<3, Ret>, bitwise_transform);
+    radix_sort_planned_passes<4>(array, size, temp, frequencies, bitwise_transform, instrument);
 }
 
 template <typename T, typename F>
-void radix_sort_64_impl(T* array, size_t size, T* temp, F bitwise_transform)
+void radix_sort_histogram_64(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform)
 {
-    size_t frequencies[8][256] = { 0 };
+    if (size >= interleaved_histogram_threshold)
+    {
+        radix_sort_histogram_interleaved<8>(array, size, frequencies, bitwise_transform);
+        return;
+    }
 
     size_t* freq_0 = frequencies[0];
     size_t* freq_1 = frequencies[1];
@@ -438,12 +1040,11 @@ void radix_sort_64_impl(T* array, size_t size, T* temp, F bitwise_transform)
     size_t* freq_6 = frequencies[6];
     size_t* freq_7 = frequencies[7];
 
-    T* array_end = array + size;
-    T* temp_end = temp + size;
+    const T* array_end = array + size;
 
     size_t unroll_size = size >> 2;
 
-    T* p = array;
+    const T* p = array;
 
     for (; unroll_size; --unroll_size, p += 4)
     {
@@ -502,140 +1103,3985 @@ void radix_sort_64_impl(T* array, size_t size, T* temp, F bitwise_transform)
         freq_6[byte<6>(h)]++;
         freq_7[byte<7>(h)]++;
     }
+}
 
-    radix_sort_calculate_offset_table_64(freq_0, freq_1, freq_2, freq_3, freq_4, freq_5, freq_6, freq_7);
+template <typename T, typename F, typename Instrument = no_instrumentation>
+void radix_sort_64_impl(T* array, size_t size, T* temp, F bitwise_transform,
+                        Instrument instrument = Instrument())
+{
+    if (size < small_sort_threshold(8))
+    {
+        instrument.begin();
+        insertion_sort(array, size, bitwise_transform);
+        instrument.end(SortPhase::insertion_sort, 2 * size * sizeof(T));
+        return;
+    }
 
-    using Ret = decltype(bitwise_transform(T()));
+    instrument.begin();
 
-    copy_with_reordering(array, array_end, temp, size, freq_0, byte<0, Ret>, bitwise_transform);
-    copy_with_reordering(temp, temp_end, array, size, freq_1, byte<1, Ret>, bitwise_transform);
-    copy_with_reordering(array, array_end, temp, size, freq_2, byte<2, Ret>, bitwise_transform);
-    copy_with_reordering(temp, temp_end, array, size, freq_3, byte<3, Ret>, bitwise_transform);
+    const size_t sorted = presorted_prefix(array, size, bitwise_transform);
 
-    copy_with_reordering(array, array_end, temp, size, freq_4, byte<4, Ret>, bitwise_transform);
-    copy_with_reordering(temp, temp_end, array, size, freq_5, byte<5, Ret>, bitwise_transform);
-    copy_with_reordering(array, array_end, temp, size, freq_6, byte<6, Ret>, bitwise_transform);
-    copy_with_reordering(temp, temp_end, array, size, freq_7, byte<7, Ret>, bitwise_transform);
-}
+    instrument.end(SortPhase::presorted_check, std::min(sorted + 1, size) * sizeof(T));
 
-void radix_sort(uint16_t* array, size_t size, uint16_t* temp)
-{
-    auto identity = [](uint16_t v) -> uint16_t
+    if (sorted == size)
     {
-        return v;
-    };
-
-    radix_sort_16_impl(array, size, temp, identity);
-}
+        instrument.skipped_passes(8);
+        return;
+    }
 
-void radix_sort(int16_t* array, size_t size, int16_t* temp)
-{
-    auto flip_sign = [](int16_t v) -> uint16_t
+    if (size - sorted <= size / append_tail_fraction)
     {
-        return *reinterpret_cast<uint16_t*>(&v) ^ (uint16_t(1) << 15);
-    };
+        radix_sort_64_impl(array + sorted, size - sorted, temp, bitwise_transform, instrument);
 
-    radix_sort_16_impl(array, size, temp, flip_sign);
-}
+        instrument.begin();
+        merge_sorted_tail(array, size, sorted, temp, bitwise_transform);
+        instrument.end(SortPhase::merge, 2 * (2 * size - sorted) * sizeof(T));
+        return;
+    }
 
-void radix_sort(uint32_t * array, size_t size, uint32_t* temp)
-{
-    auto identity = [](uint32_t v) -> uint32_t
-    {
-        return v;
-    };
+    instrument.begin();
+
+    size_t frequencies[8][256] = { 0 };
 
-    radix_sort_32_impl(array, size, temp, identity);
+    radix_sort_histogram_64(array, size, frequencies, bitwise_transform);
+
+    instrument.end(SortPhase::histogram, size * sizeof(T));
+
+    radix_sort_planned_passes<8>(array, size, temp, frequencies, bitwise_transform, instrument);
 }
 
-void radix_sort(int32_t * array, size_t size, int32_t* temp)
+template <typename T, typename F, typename Instrument = no_instrumentation>
+void radix_sort_8_impl(T* array, size_t size, T* temp, F bitwise_transform,
+                       Instrument instrument = Instrument())
 {
-    auto flip_sign = [](int32_t v) -> uint32_t
-    {
+    instrument.begin();
+
+    size_t frequencies[1][256] = { { 0 } };
+
+    T* array_end = array + size;
+
+    radix_sort_histogram_8(array, size, frequencies, bitwise_transform);
+
+    radix_sort_calculate_offset_table_8(frequencies[0]);
+
+    instrument.end(SortPhase::histogram, size * sizeof(T));
+    instrument.begin();
+
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    copy_with_reordering(array, array_end, temp, size, frequencies[0], byte<0, Ret>, bitwise_transform);
+
+    instrument.end(SortPhase::pass, 2 * size * sizeof(T), 0);
+    instrument.begin();
+
+    std::copy(temp, temp + size, array);
+
+    instrument.end(SortPhase::copy_back, 2 * size * sizeof(T));
+}
+
+// Transformed keys wider than the byte engines above handle: integers wider than 64 bits
+// and big-endian byte arrays of any length, which sort like memcmp.
+template <typename Ret>
+struct is_wide_key : std::false_type
+{
+};
+
+#ifdef RADIX_SORT_HAS_INT128
+template <>
+struct is_wide_key<unsigned __int128> : std::true_type
+{
+};
+#endif
+
+template <size_t N>
+struct is_wide_key<std::array<uint8_t, N>> : std::true_type
+{
+};
+
+// Byte index of a wide key, 0 being the least significant one.
+template <typename Ret>
+inline size_t key_byte(Ret value, unsigned index)
+{
+    return size_t(value >> (index * CHAR_BIT)) & 255;
+}
+
+template <size_t N>
+inline size_t key_byte(const std::array<uint8_t, N>& value, unsigned index)
+{
+    return value[N - 1 - index];
+}
+
+// Wide keys in which more bytes than this differ are sorted MSD first. Measured on 10M
+// 128 bit keys: LSD is faster with 4 differing bytes, MSD with 5 and up.
+const unsigned wide_lsd_max_passes = 4;
+
+// MSD buckets of wide keys smaller than this are insertion sorted.
+const size_t wide_insertion_threshold = 32;
+
+// Sets the bits of diff in which key differs from first.
+template <typename Ret>
+inline void accumulate_differences(Ret& diff, const Ret& key, const Ret& first)
+{
+    diff |= key ^ first;
+}
+
+template <size_t N>
+inline void accumulate_differences(std::array<uint8_t, N>& diff, const std::array<uint8_t, N>& key,
+                                   const std::array<uint8_t, N>& first)
+{
+    for (size_t i = 0; i < N; ++i)
+        diff[i] |= key[i] ^ first[i];
+}
+
+// Counts the histograms of the num_digits key bytes at indices in one pass.
+template <typename T, typename F>
+void radix_sort_histogram_wide(const T* array, size_t size, std::array<size_t, 256>* frequencies,
+                               const unsigned* indices, unsigned num_digits, F bitwise_transform)
+{
+    for (const T* p = array; p != array + size; ++p)
+    {
+        const auto key = bitwise_transform(*p);
+
+        for (unsigned d = 0; d < num_digits; ++d)
+            frequencies[d][key_byte(key, indices[d])]++;
+    }
+}
+
+// An MSD bucket of radix_sort_wide_impl still to be sorted: [begin, begin + size) of array
+// if in_array, of temp otherwise. Bytes digits and up are equal across the bucket.
+struct wide_bucket
+{
+    size_t begin;
+    size_t size;
+    unsigned digits;
+    bool in_array;
+};
+
+// Sorts the MSD buckets of radix_sort_wide_impl into array. A bucket is split by its byte
+// digits - 1 into the same range of the other buffer, like hybrid_sort_bucket, and bytes
+// that are the same for all its elements are skipped without moving anything. The buckets
+// are kept on the explicit stack pending instead of recursing, since keys can have any
+// number of bytes.
+template <typename T, typename F>
+void wide_sort_buckets(T* array, T* temp, std::vector<wide_bucket>& pending, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    size_t freq[256];
+    size_t begins[257];
+
+    while (!pending.empty())
+    {
+        const wide_bucket bucket = pending.back();
+        pending.pop_back();
+
+        T* data = (bucket.in_array ? array : temp) + bucket.begin;
+        T* other = (bucket.in_array ? temp : array) + bucket.begin;
+        const size_t size = bucket.size;
+
+        unsigned digits = bucket.digits;
+
+        for (; digits > 0 && size >= wide_insertion_threshold; --digits)
+        {
+            std::fill(freq, freq + 256, size_t(0));
+
+            for (T* p = data; p != data + size; ++p)
+                freq[key_byte(bitwise_transform(*p), digits - 1)]++;
+
+            if (freq[key_byte(bitwise_transform(data[0]), digits - 1)] != size)
+                break;
+        }
+
+        if (digits == 0 || size < wide_insertion_threshold)
+        {
+            if (digits > 0)
+                insertion_sort(data, size, bitwise_transform);
+
+            if (!bucket.in_array)
+                std::copy(data, data + size, other);
+
+            continue;
+        }
+
+        const unsigned index = digits - 1;
+
+        auto extract_byte = [index](const Ret& v) -> size_t
+        {
+            return key_byte(v, index);
+        };
+
+        begins[0] = 0;
+
+        for (size_t i = 0; i < 256; ++i)
+        {
+            begins[i + 1] = begins[i] + freq[i];
+            freq[i] = begins[i];
+        }
+
+        copy_with_reordering(data, data + size, other, size, freq, extract_byte, bitwise_transform);
+
+        // Small buckets split into mostly empty and single element ones, which are moved here
+        // rather than pushed.
+        for (size_t i = 256; i-- > 0;)
+        {
+            const size_t count = begins[i + 1] - begins[i];
+
+            if (count > 1)
+                pending.push_back(wide_bucket{ bucket.begin + begins[i], count, index, !bucket.in_array });
+            else if (count == 1 && bucket.in_array)
+                data[begins[i]] = other[begins[i]];
+        }
+    }
+}
+
+// Radix sort of wide keys, generic over their num_bytes bytes. A first pass finds the bytes
+// that differ between elements; the others take no pass and are not even counted. When at
+// most wide_lsd_max_passes bytes differ, they are counted in one pass and sorted LSD like
+// the narrower keys. When more do, e.g. random UUIDs, the elements are usually told apart
+// by their first few differing bytes: one MSD pass on the most significant one scatters
+// the array into temp and wide_sort_buckets splits every bucket further until it is small
+// enough to insertion sort.
+template <size_t num_bytes, typename T, typename F, typename Instrument>
+void radix_sort_wide_impl(T* array, size_t size, T* temp, F bitwise_transform, Instrument instrument)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    if (size < small_sort_threshold(num_bytes))
+    {
+        instrument.begin();
+        insertion_sort(array, size, bitwise_transform);
+        instrument.end(SortPhase::insertion_sort, 2 * size * sizeof(T));
+        return;
+    }
+
+    instrument.begin();
+
+    const size_t sorted = presorted_prefix(array, size, bitwise_transform);
+
+    instrument.end(SortPhase::presorted_check, std::min(sorted + 1, size) * sizeof(T));
+
+    if (sorted == size)
+    {
+        instrument.skipped_passes(num_bytes);
+        return;
+    }
+
+    if (size - sorted <= size / append_tail_fraction)
+    {
+        radix_sort_wide_impl<num_bytes>(array + sorted, size - sorted, temp, bitwise_transform, instrument);
+
+        instrument.begin();
+        merge_sorted_tail(array, size, sorted, temp, bitwise_transform);
+        instrument.end(SortPhase::merge, 2 * (2 * size - sorted) * sizeof(T));
+        return;
+    }
+
+    instrument.begin();
+
+    // Counting all num_bytes histograms would cost more than the passes, find the bytes
+    // that differ between elements first.
+    const Ret first = bitwise_transform(array[0]);
+
+    Ret diff = Ret();
+
+    for (T* p = array; p != array + size; ++p)
+        accumulate_differences(diff, bitwise_transform(*p), first);
+
+    unsigned indices[num_bytes];
+    unsigned num_passes = 0;
+
+    for (unsigned i = 0; i < num_bytes; ++i)
+    {
+        if (key_byte(diff, i) != 0)
+            indices[num_passes++] = i;
+    }
+
+    instrument.end(SortPhase::planning, size * sizeof(T));
+    instrument.skipped_passes(unsigned(num_bytes) - num_passes);
+
+    if (num_passes > wide_lsd_max_passes)
+    {
+        const unsigned index = indices[num_passes - 1];
+
+        auto extract_byte = [index](const Ret& v) -> size_t
+        {
+            return key_byte(v, index);
+        };
+
+        instrument.begin();
+
+        std::array<size_t, 256> freq = { { 0 } };
+
+        radix_sort_histogram_wide(array, size, &freq, &index, 1, bitwise_transform);
+
+        size_t begins[257];
+
+        begins[0] = 0;
+
+        for (size_t i = 0; i < 256; ++i)
+        {
+            begins[i + 1] = begins[i] + freq[i];
+            freq[i] = begins[i];
+        }
+
+        instrument.end(SortPhase::histogram, size * sizeof(T));
+        instrument.begin();
+
+        copy_with_reordering(array, array + size, temp, size, freq.data(), extract_byte, bitwise_transform);
+
+        instrument.end(SortPhase::pass, 2 * size * sizeof(T), 0);
+        instrument.begin();
+
+        std::vector<wide_bucket> pending;
+
+        for (size_t i = 256; i-- > 0;)
+        {
+            if (begins[i + 1] != begins[i])
+                pending.push_back(wide_bucket{ begins[i], begins[i + 1] - begins[i], index, false });
+        }
+
+        wide_sort_buckets(array, temp, pending, bitwise_transform);
+
+        // The buckets are split further and end up back in array.
+        instrument.end(SortPhase::pass, 2 * size * sizeof(T), 1);
+        return;
+    }
+
+    instrument.begin();
+
+    std::vector<std::array<size_t, 256>> frequencies(num_passes);
+
+    radix_sort_histogram_wide(array, size, frequencies.data(), indices, num_passes, bitwise_transform);
+
+    for (unsigned pass = 0; pass < num_passes; ++pass)
+    {
+        size_t offset = 0;
+
+        for (size_t& count : frequencies[pass])
+        {
+            const size_t next = offset + count;
+            count = offset;
+            offset = next;
+        }
+    }
+
+    instrument.end(SortPhase::histogram, size * sizeof(T));
+
+    T* src = array;
+    T* dst = temp;
+
+    for (unsigned pass = 0; pass < num_passes; ++pass)
+    {
+        const unsigned index = indices[pass];
+
+        auto extract_byte = [index](const Ret& v) -> size_t
+        {
+            return key_byte(v, index);
+        };
+
+        instrument.begin();
+
+        copy_with_reordering(src, src + size, dst, size, frequencies[pass].data(), extract_byte,
+                             bitwise_transform);
+
+        instrument.end(SortPhase::pass, 2 * size * sizeof(T), pass);
+
+        std::swap(src, dst);
+    }
+
+    if (src != array)
+    {
+        instrument.begin();
+        std::copy(src, src + size, array);
+        instrument.end(SortPhase::copy_back, 2 * size * sizeof(T));
+    }
+}
+
+// Picks the LSD engine by the size of the transformed key.
+template <typename T, typename F, typename Instrument>
+void radix_sort_impl(T* array, size_t size, T* temp, F bitwise_transform, std::integral_constant<size_t, 1>,
+                     Instrument instrument)
+{
+    radix_sort_8_impl(array, size, temp, bitwise_transform, instrument);
+}
+
+template <typename T, typename F, typename Instrument>
+void radix_sort_impl(T* array, size_t size, T* temp, F bitwise_transform, std::integral_constant<size_t, 2>,
+                     Instrument instrument)
+{
+    radix_sort_16_impl(array, size, temp, bitwise_transform, instrument);
+}
+
+template <typename T, typename F, typename Instrument>
+void radix_sort_impl(T* array, size_t size, T* temp, F bitwise_transform, std::integral_constant<size_t, 4>,
+                     Instrument instrument)
+{
+    radix_sort_32_impl(array, size, temp, bitwise_transform, instrument);
+}
+
+template <typename T, typename F, typename Instrument>
+void radix_sort_impl(T* array, size_t size, T* temp, F bitwise_transform, std::integral_constant<size_t, 8>,
+                     Instrument instrument)
+{
+    radix_sort_64_impl(array, size, temp, bitwise_transform, instrument);
+}
+
+template <typename T, typename F, typename Instrument>
+void radix_sort_impl(T* array, size_t size, T* temp, F bitwise_transform, std::true_type /* wide key */,
+                     Instrument instrument)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    radix_sort_wide_impl<sizeof(Ret)>(array, size, temp, bitwise_transform, instrument);
+}
+
+template <typename T, typename F, typename Instrument>
+void radix_sort_impl(T* array, size_t size, T* temp, F bitwise_transform, std::false_type /* wide key */,
+                     Instrument instrument)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    radix_sort_impl(array, size, temp, bitwise_transform, std::integral_constant<size_t, sizeof(Ret)>(), instrument);
+}
+
+template <typename T, typename F, typename Instrument = no_instrumentation>
+void radix_sort_impl(T* array, size_t size, T* temp, F bitwise_transform, Instrument instrument = Instrument())
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    radix_sort_impl(array, size, temp, bitwise_transform, is_wide_key<Ret>(), instrument);
+}
+
+template <unsigned DigitBits, unsigned index, typename T>
+inline size_t digit(T value)
+{
+    return (value >> (index * DigitBits)) & ((size_t(1) << DigitBits) - 1);
+}
+
+template <unsigned DigitBits, typename Ret, unsigned index, unsigned num_passes>
+struct digit_histogram
+{
+    static void count(Ret value, size_t* frequencies)
+    {
+        frequencies[index * (size_t(1) << DigitBits) + digit<DigitBits, index>(value)]++;
+        digit_histogram<DigitBits, Ret, index + 1, num_passes>::count(value, frequencies);
+    }
+};
+
+template <unsigned DigitBits, typename Ret, unsigned num_passes>
+struct digit_histogram<DigitBits, Ret, num_passes, num_passes>
+{
+    static void count(Ret, size_t*)
+    {
+    }
+};
+
+// Number of counters radix_sort_lsd_impl needs: one histogram per pass.
+constexpr size_t lsd_histogram_size(size_t key_size, unsigned digit_bits)
+{
+    return (key_size * CHAR_BIT + digit_bits - 1) / digit_bits << digit_bits;
+}
+
+// LSD radix sort with DigitBits wide digits instead of bytes:
+// sizeof(key) * CHAR_BIT / DigitBits passes (rounded up), 2^DigitBits buckets each.
+// Wider digits mean fewer passes over the array but larger histograms.
+// frequencies must hold lsd_histogram_size(sizeof(key), DigitBits) zeroed counters.
+template <unsigned DigitBits, typename T, typename F>
+void radix_sort_lsd_impl(T* array, size_t size, T* temp, F bitwise_transform, size_t* frequencies)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    static_assert(DigitBits > 0 && DigitBits <= 16, "Digits must be 1 to 16 bits wide");
+
+    const unsigned num_passes = (sizeof(Ret) * CHAR_BIT + DigitBits - 1) / DigitBits;
+    const size_t buckets = size_t(1) << DigitBits;
+
+    for (T* p = array; p != array + size; ++p)
+        digit_histogram<DigitBits, Ret, 0, num_passes>::count(bitwise_transform(*p), frequencies);
+
+    for (unsigned pass = 0; pass < num_passes; ++pass)
+    {
+        size_t* freq = &frequencies[pass * buckets];
+        size_t offset = 0;
+
+        for (size_t i = 0; i < buckets; ++i)
+        {
+            size_t temp_offset = freq[i] + offset;
+            freq[i] = offset;
+            offset = temp_offset;
+        }
+    }
+
+    T* src = array;
+    T* dst = temp;
+
+    for (unsigned pass = 0; pass < num_passes; ++pass)
+    {
+        const unsigned shift = pass * DigitBits;
+
+        auto extract_digit = [shift](Ret v) -> size_t
+        {
+            return (v >> shift) & (buckets - 1);
+        };
+
+        copy_with_reordering<buckets>(src, src + size, dst, size, &frequencies[pass * buckets],
+                                      extract_digit, bitwise_transform);
+
+        std::swap(src, dst);
+    }
+
+    if (src != array)
+        std::copy(src, src + size, array);
+}
+
+template <unsigned DigitBits, typename T, typename F>
+void radix_sort_lsd_impl(T* array, size_t size, T* temp, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    std::vector<size_t> frequencies(lsd_histogram_size(sizeof(Ret), DigitBits));
+
+    radix_sort_lsd_impl<DigitBits>(array, size, temp, bitwise_transform, frequencies.data());
+}
+
+// Width-dispatching wrappers over the histogram and offset table functions above,
+// for code that is generic over the key size (sizeof of the transformed key).
+template <typename T, typename F>
+void radix_sort_histogram(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform,
+                          std::integral_constant<size_t, 1>)
+{
+    radix_sort_histogram_8(array, size, frequencies, bitwise_transform);
+}
+
+template <typename T, typename F>
+void radix_sort_histogram(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform,
+                          std::integral_constant<size_t, 2>)
+{
+    radix_sort_histogram_16(array, size, frequencies, bitwise_transform);
+}
+
+template <typename T, typename F>
+void radix_sort_histogram(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform,
+                          std::integral_constant<size_t, 4>)
+{
+    radix_sort_histogram_32(array, size, frequencies, bitwise_transform);
+}
+
+template <typename T, typename F>
+void radix_sort_histogram(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform,
+                          std::integral_constant<size_t, 8>)
+{
+    radix_sort_histogram_64(array, size, frequencies, bitwise_transform);
+}
+
+template <typename T, typename F>
+void radix_sort_histogram(const T* array, size_t size, size_t (*frequencies)[256], F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    radix_sort_histogram(array, size, frequencies, bitwise_transform,
+                         std::integral_constant<size_t, sizeof(Ret)>());
+}
+
+inline void radix_sort_calculate_offset_table(size_t (*frequencies)[256], std::integral_constant<size_t, 1>)
+{
+    radix_sort_calculate_offset_table_8(frequencies[0]);
+}
+
+inline void radix_sort_calculate_offset_table(size_t (*frequencies)[256], std::integral_constant<size_t, 2>)
+{
+    radix_sort_calculate_offset_table_16(frequencies[0], frequencies[1]);
+}
+
+inline void radix_sort_calculate_offset_table(size_t (*frequencies)[256], std::integral_constant<size_t, 4>)
+{
+    radix_sort_calculate_offset_table_32(frequencies[0], frequencies[1], frequencies[2], frequencies[3]);
+}
+
+inline void radix_sort_calculate_offset_table(size_t (*frequencies)[256], std::integral_constant<size_t, 8>)
+{
+    radix_sort_calculate_offset_table_64(frequencies[0], frequencies[1], frequencies[2], frequencies[3],
+                                         frequencies[4], frequencies[5], frequencies[6], frequencies[7]);
+}
+
+template <typename T>
+struct key_transform;
+
+template <>
+struct key_transform<uint8_t>
+{
+    uint8_t operator()(uint8_t v) const
+    {
+        return v;
+    }
+};
+
+template <>
+struct key_transform<int8_t>
+{
+    uint8_t operator()(int8_t v) const
+    {
+        return *reinterpret_cast<uint8_t*>(&v) ^ (uint8_t(1) << 7);
+    }
+};
+
+template <>
+struct key_transform<uint16_t>
+{
+    uint16_t operator()(uint16_t v) const
+    {
+        return v;
+    }
+};
+
+template <>
+struct key_transform<int16_t>
+{
+    uint16_t operator()(int16_t v) const
+    {
+        return *reinterpret_cast<uint16_t*>(&v) ^ (uint16_t(1) << 15);
+    }
+};
+
+template <>
+struct key_transform<uint32_t>
+{
+    uint32_t operator()(uint32_t v) const
+    {
+        return v;
+    }
+};
+
+template <>
+struct key_transform<int32_t>
+{
+    uint32_t operator()(int32_t v) const
+    {
         return *reinterpret_cast<uint32_t*>(&v) ^ (uint32_t(1) << 31);
+    }
+};
+
+template <>
+struct key_transform<uint64_t>
+{
+    uint64_t operator()(uint64_t v) const
+    {
+        return v;
+    }
+};
+
+template <>
+struct key_transform<int64_t>
+{
+    uint64_t operator()(int64_t v) const
+    {
+        return *reinterpret_cast<uint64_t*>(&v) ^ (uint64_t(1) << 63);
+    }
+};
+
+#ifdef RADIX_SORT_HAS_INT128
+template <>
+struct key_transform<unsigned __int128>
+{
+    unsigned __int128 operator()(unsigned __int128 v) const
+    {
+        return v;
+    }
+};
+
+template <>
+struct key_transform<__int128>
+{
+    unsigned __int128 operator()(__int128 v) const
+    {
+        return static_cast<unsigned __int128>(v) ^ (static_cast<unsigned __int128>(1) << 127);
+    }
+};
+#endif
+
+// Byte arrays are big-endian keys: they sort like memcmp, e.g. UUIDs in their RFC 4122 layout.
+template <size_t N>
+struct key_transform<std::array<uint8_t, N>>
+{
+    std::array<uint8_t, N> operator()(const std::array<uint8_t, N>& v) const
+    {
+        return v;
+    }
+};
+
+// How the floating point overloads order special values.
+enum class FloatOrder
+{
+    // IEEE 754 totalOrder: -NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN.
+    total_order,
+
+    // The order std::stable_sort gives with std::less on non-NaN values: -0 and +0 are
+    // equal and keep their input order. NaNs of either sign go last, also in input order.
+    nans_last
+};
+
+// Bit patterns of positive infinity. Any pattern with a larger magnitude is a NaN.
+const uint16_t float16_infinity_bits = 0x7c00;
+const uint16_t bfloat16_infinity_bits = 0x7f80;
+const uint32_t float_infinity_bits = 0x7f800000;
+const uint64_t double_infinity_bits = 0x7ff0000000000000;
+
+// Maps the bits of an IEEE 754 binary number to an unsigned integer in the requested order.
+template <typename UInt, UInt infinity_bits, FloatOrder order>
+struct float_bits_transform;
+
+template <typename UInt, UInt infinity_bits>
+struct float_bits_transform<UInt, infinity_bits, FloatOrder::total_order>
+{
+    UInt operator()(UInt bits) const
+    {
+        const unsigned sign_shift = sizeof(UInt) * CHAR_BIT - 1;
+
+        // Negative numbers: flip all bits. Positive numbers: flip the sign bit.
+        UInt mask = UInt(UInt(0) - (bits >> sign_shift)) | UInt(UInt(1) << sign_shift);
+        return bits ^ mask;
+    }
+};
+
+template <typename UInt, UInt infinity_bits>
+struct float_bits_transform<UInt, infinity_bits, FloatOrder::nans_last>
+{
+    UInt operator()(UInt bits) const
+    {
+        const UInt sign = UInt(UInt(1) << (sizeof(UInt) * CHAR_BIT - 1));
+        const UInt magnitude = bits & UInt(~sign);
+
+        UInt key = float_bits_transform<UInt, infinity_bits, FloatOrder::total_order>()(bits);
+        key = magnitude == 0 ? sign : key;
+        key = magnitude > infinity_bits ? UInt(~UInt(0)) : key;
+        return key;
+    }
+};
+
+// Applies float_bits_transform to the bits of a floating point value of type F.
+template <typename F, typename UInt, UInt infinity_bits, FloatOrder order>
+struct float_key_transform
+{
+    static_assert(sizeof(F) == sizeof(UInt), "Floating point type and its bits must have the same size");
+
+    UInt operator()(F v) const
+    {
+        UInt bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return float_bits_transform<UInt, infinity_bits, order>()(bits);
+    }
+};
+
+template <>
+struct key_transform<float> : float_key_transform<float, uint32_t, float_infinity_bits, FloatOrder::total_order>
+{
+    static_assert(std::numeric_limits<float>::is_iec559, "Only IEEE 754 floating point");
+};
+
+template <>
+struct key_transform<double> : float_key_transform<double, uint64_t, double_infinity_bits, FloatOrder::total_order>
+{
+    static_assert(std::numeric_limits<double>::is_iec559, "Only IEEE 754 floating point");
+};
+
+#ifdef RADIX_SORT_HAS_FLOAT16
+template <>
+struct key_transform<_Float16> : float_key_transform<_Float16, uint16_t, float16_infinity_bits, FloatOrder::total_order>
+{
+};
+#endif
+
+#ifdef RADIX_SORT_HAS_BFLOAT16
+template <>
+struct key_transform<std::bfloat16_t> : float_key_transform<std::bfloat16_t, uint16_t, bfloat16_infinity_bits, FloatOrder::total_order>
+{
+};
+#endif
+
+// Reusable scratch memory for the sorts below, so that sorting in a loop doesn't allocate,
+// page fault and miss the TLB on a fresh temporary buffer every time. Every overload that
+// allocates has a variant that takes a Workspace& instead.
+// The scratch buffer is page aligned, mapped with MAP_HUGETLB if the system has huge pages
+// reserved and otherwise advised to use transparent huge pages, and pre-faulted. It grows
+// at least 2x at a time and its contents are not preserved when it grows.
+// Histogram and offset tables that don't fit on the stack are kept in a separate reused array.
+// A Workspace must not be shared by sorts that run at the same time.
+class Workspace
+{
+public:
+    explicit Workspace(size_t bytes = 0, bool huge_pages = true)
+        : buffer(nullptr), buffer_size(0), huge_pages(huge_pages)
+    {
+        reserve(bytes);
+    }
+
+    ~Workspace()
+    {
+        release();
+    }
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    size_t capacity() const
+    {
+        return buffer_size;
+    }
+
+    void reserve(size_t bytes)
+    {
+        if (bytes <= buffer_size)
+            return;
+
+        release();
+        allocate(std::max(bytes, 2 * buffer_size));
+    }
+
+    template <typename T>
+    T* scratch(size_t count)
+    {
+        reserve(count * sizeof(T));
+        return static_cast<T*>(buffer);
+    }
+
+    // Two arrays in the scratch buffer, the second one starting on a cache line boundary.
+    template <typename T, typename U>
+    std::pair<T*, U*> scratch(size_t count_t, size_t count_u)
+    {
+        const size_t offset = (count_t * sizeof(T) + cache_line_size - 1) / cache_line_size * cache_line_size;
+
+        reserve(offset + count_u * sizeof(U));
+
+        char* base = static_cast<char*>(buffer);
+        return std::make_pair(reinterpret_cast<T*>(base), reinterpret_cast<U*>(base + offset));
+    }
+
+    // count zeroed counters.
+    size_t* tables(size_t count)
+    {
+        if (counters.size() < count)
+            counters.resize(count);
+
+        std::fill(counters.begin(), counters.begin() + count, size_t(0));
+        return counters.data();
+    }
+
+private:
+    static const size_t huge_page_size = size_t(2) << 20;
+    static const size_t page_size = size_t(4) << 10;
+
+    void allocate(size_t bytes)
+    {
+#ifdef RADIX_SORT_HAS_MMAP
+        const size_t granularity = huge_pages && bytes >= huge_page_size / 2 ? huge_page_size : page_size;
+        bytes = (bytes + granularity - 1) / granularity * granularity;
+
+#if defined(MAP_HUGETLB) && defined(MAP_POPULATE)
+        if (granularity == huge_page_size)
+        {
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+
+            if (p != MAP_FAILED)
+            {
+                buffer = p;
+                buffer_size = bytes;
+                return;
+            }
+        }
+#endif
+
+        // Map one huge page more than needed and trim it, so that the buffer starts on a
+        // huge page boundary and transparent huge pages can back all of it.
+        const size_t slack = granularity == huge_page_size ? huge_page_size : 0;
+
+        char* p = static_cast<char*>(mmap(nullptr, bytes + slack, PROT_READ | PROT_WRITE,
+                                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+
+        if (slack)
+        {
+            char* aligned = p + (huge_page_size - uintptr_t(p) % huge_page_size) % huge_page_size;
+
+            if (aligned != p)
+                munmap(p, aligned - p);
+
+            if (aligned + bytes != p + bytes + slack)
+                munmap(aligned + bytes, p + slack - aligned);
+
+            p = aligned;
+
+#ifdef MADV_HUGEPAGE
+            madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+        }
+
+        // Pre-fault every page now instead of during the first sort.
+        for (size_t i = 0; i < bytes; i += page_size)
+            static_cast<volatile char*>(p)[i] = 0;
+
+        buffer = p;
+        buffer_size = bytes;
+#else
+        buffer = ::operator new(bytes);
+        buffer_size = bytes;
+#endif
+    }
+
+    void release()
+    {
+        if (!buffer)
+            return;
+
+#ifdef RADIX_SORT_HAS_MMAP
+        munmap(buffer, buffer_size);
+#else
+        ::operator delete(buffer);
+#endif
+        buffer = nullptr;
+        buffer_size = 0;
+    }
+
+    void* buffer;
+    size_t buffer_size;
+    bool huge_pages;
+    std::vector<size_t> counters;
+};
+
+// Keys that are sorted by counting: every value has a bucket of its own, so the sorted
+// array can be written back from the bucket counts alone, without a temporary buffer.
+template <typename T>
+struct is_counting_sort_key : std::integral_constant<bool,
+    std::is_same<T, uint8_t>::value || std::is_same<T, int8_t>::value ||
+    std::is_same<T, uint16_t>::value || std::is_same<T, int16_t>::value>
+{
+};
+
+template <typename T>
+constexpr size_t counting_sort_buckets()
+{
+    return size_t(1) << (sizeof(T) * CHAR_BIT);
+}
+
+// 16 bit arrays shorter than this are radix sorted instead: clearing and scanning
+// 65536 buckets costs more than two passes over them.
+const size_t counting_sort_threshold = size_t(1) << 16;
+
+template <typename T>
+bool counting_sort_pays_off(size_t size)
+{
+    return is_counting_sort_key<T>::value && (sizeof(T) == 1 || size >= counting_sort_threshold);
+}
+
+// Largest value range radix_sort_counting sorts by counting.
+const size_t counting_sort_max_buckets = size_t(1) << 20;
+
+template <typename T>
+size_t counting_bucket(T value, T min_value)
+{
+    using U = typename std::make_unsigned<T>::type;
+
+    return size_t(U(U(value) - U(min_value)));
+}
+
+template <typename T>
+T counting_value(size_t bucket, T min_value)
+{
+    using U = typename std::make_unsigned<T>::type;
+
+    return T(U(U(min_value) + U(bucket)));
+}
+
+template <typename T>
+void fill_run(T* array, size_t count, T value)
+{
+    std::fill_n(array, count, value);
+}
+
+inline void fill_run(uint8_t* array, size_t count, uint8_t value)
+{
+    std::memset(array, value, count);
+}
+
+inline void fill_run(int8_t* array, size_t count, int8_t value)
+{
+    std::memset(array, uint8_t(value), count);
+}
+
+#ifdef RADIX_SORT_HAS_SSE2
+inline void fill_run(uint16_t* array, size_t count, uint16_t value)
+{
+    const __m128i v = _mm_set1_epi16(short(value));
+
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(array + i), v);
+
+    for (; i < count; ++i)
+        array[i] = value;
+}
+
+inline void fill_run(int16_t* array, size_t count, int16_t value)
+{
+    fill_run(reinterpret_cast<uint16_t*>(array), count, uint16_t(value));
+}
+#endif
+
+// Adds the bucket of every element to counts.
+template <typename T, typename Count>
+void counting_sort_histogram(const T* array, size_t size, Count* counts, T min_value)
+{
+    const T* array_end = array + size;
+
+    size_t unroll_size = size >> 2;
+
+    const T* p = array;
+
+    for (; unroll_size; --unroll_size, p += 4)
+    {
+        counts[counting_bucket(*p, min_value)]++;
+        counts[counting_bucket(*(p + 1), min_value)]++;
+        counts[counting_bucket(*(p + 2), min_value)]++;
+        counts[counting_bucket(*(p + 3), min_value)]++;
+    }
+
+    for (; p != array_end; ++p)
+        counts[counting_bucket(*p, min_value)]++;
+}
+
+// 256 buckets: counting into interleaved copies of the table keeps runs of equal bytes
+// from waiting on each other's increments of the same counter, 3-4x faster on them.
+template <typename T>
+void counting_sort_histogram_8(const T* array, size_t size, size_t* counts)
+{
+    const T min_value = std::numeric_limits<T>::min();
+
+    size_t freq_0[256] = { 0 };
+    size_t freq_1[256] = { 0 };
+    size_t freq_2[256] = { 0 };
+    size_t freq_3[256] = { 0 };
+
+    const T* array_end = array + size;
+
+    size_t unroll_size = size >> 2;
+
+    const T* p = array;
+
+    for (; unroll_size; --unroll_size, p += 4)
+    {
+        freq_0[counting_bucket(*p, min_value)]++;
+        freq_1[counting_bucket(*(p + 1), min_value)]++;
+        freq_2[counting_bucket(*(p + 2), min_value)]++;
+        freq_3[counting_bucket(*(p + 3), min_value)]++;
+    }
+
+    for (; p != array_end; ++p)
+        freq_0[counting_bucket(*p, min_value)]++;
+
+    for (size_t bucket = 0; bucket < 256; ++bucket)
+        counts[bucket] += freq_0[bucket] + freq_1[bucket] + freq_2[bucket] + freq_3[bucket];
+}
+
+// Turns bucket counts into the end offset of every bucket in the sorted array.
+template <typename Count>
+void counting_sort_ends(Count* counts, size_t num_buckets)
+{
+    for (size_t bucket = 1; bucket < num_buckets; ++bucket)
+        counts[bucket] += counts[bucket - 1];
+}
+
+// Writes the sorted values to array[position, end), where ends[b] is the end offset of
+// bucket b and bucket is the one that position falls into. With about as many elements
+// as buckets most runs are empty or short, and a branch on every run length mispredicts
+// half the time; instead a whole 16 byte block of the value is written unconditionally
+// and the next bucket overwrites what isn't its own. 7x faster at 1 element per bucket.
+template <typename T, typename Count>
+void counting_sort_fill(T* array, size_t position, size_t end, const Count* ends, size_t bucket, T min_value)
+{
+    const size_t block = sizeof(T) < 16 ? 16 / sizeof(T) : 1;
+
+    for (; position < end; ++bucket)
+    {
+        const size_t run_end = std::min(size_t(ends[bucket]), end);
+        const T value = counting_value<T>(bucket, min_value);
+
+        if (end - position >= block)
+        {
+            for (size_t i = 0; i < block; ++i)
+                array[position + i] = value;
+
+            if (run_end - position > block)
+                fill_run(array + position + block, run_end - position - block, value);
+        }
+        else
+        {
+            fill_run(array + position, run_end - position, value);
+        }
+
+        position = run_end;
+    }
+}
+
+// Counting sort of integers in [min_value, min_value + num_buckets): one read pass to
+// count, one write pass to fill in the values. counts must hold num_buckets zeros.
+template <typename T, typename Count>
+void counting_sort_impl(T* array, size_t size, Count* counts, size_t num_buckets, T min_value)
+{
+    counting_sort_histogram(array, size, counts, min_value);
+    counting_sort_ends(counts, num_buckets);
+    counting_sort_fill(array, 0, size, counts, 0, min_value);
+}
+
+// 16 bit counting sort with 32 bit counts when they can't overflow, halving the table.
+template <typename T>
+void counting_sort_16(T* array, size_t size)
+{
+    if (size <= std::numeric_limits<uint32_t>::max())
+    {
+        std::vector<uint32_t> counts(counting_sort_buckets<T>());
+        counting_sort_impl(array, size, counts.data(), counts.size(), std::numeric_limits<T>::min());
+    }
+    else
+    {
+        std::vector<size_t> counts(counting_sort_buckets<T>());
+        counting_sort_impl(array, size, counts.data(), counts.size(), std::numeric_limits<T>::min());
+    }
+}
+
+// Large 16 bit arrays are sorted by counting and don't touch temp.
+void radix_sort(uint16_t* array, size_t size, uint16_t* temp)
+{
+    if (size >= counting_sort_threshold)
+        counting_sort_16(array, size);
+    else
+        radix_sort_16_impl(array, size, temp, key_transform<uint16_t>());
+}
+
+void radix_sort(int16_t* array, size_t size, int16_t* temp)
+{
+    if (size >= counting_sort_threshold)
+        counting_sort_16(array, size);
+    else
+        radix_sort_16_impl(array, size, temp, key_transform<int16_t>());
+}
+
+void radix_sort(uint32_t * array, size_t size, uint32_t* temp)
+{
+    radix_sort_32_impl(array, size, temp, key_transform<uint32_t>());
+}
+
+void radix_sort(int32_t * array, size_t size, int32_t* temp)
+{
+    radix_sort_32_impl(array, size, temp, key_transform<int32_t>());
+}
+
+void radix_sort(uint64_t* array, size_t size, uint64_t* temp)
+{
+    radix_sort_64_impl(array, size, temp, key_transform<uint64_t>());
+}
+
+void radix_sort(int64_t * array, size_t size, int64_t* temp)
+{
+    radix_sort_64_impl(array, size, temp, key_transform<int64_t>());
+}
+
+#ifdef RADIX_SORT_HAS_INT128
+inline void radix_sort(unsigned __int128* array, size_t size, unsigned __int128* temp)
+{
+    radix_sort_impl(array, size, temp, key_transform<unsigned __int128>());
+}
+
+inline void radix_sort(__int128* array, size_t size, __int128* temp)
+{
+    radix_sort_impl(array, size, temp, key_transform<__int128>());
+}
+#endif
+
+template <size_t N>
+void radix_sort(std::array<uint8_t, N>* array, size_t size, std::array<uint8_t, N>* temp)
+{
+    radix_sort_impl(array, size, temp, key_transform<std::array<uint8_t, N>>());
+}
+
+void radix_sort(float* array, size_t size, float* temp)
+{
+    radix_sort_32_impl(array, size, temp, key_transform<float>());
+}
+
+template <typename T, typename UInt, UInt infinity_bits>
+void radix_sort_float_impl(T* array, size_t size, T* temp, FloatOrder order)
+{
+    if (order == FloatOrder::nans_last)
+        radix_sort_impl(array, size, temp, float_key_transform<T, UInt, infinity_bits, FloatOrder::nans_last>());
+    else
+        radix_sort_impl(array, size, temp, float_key_transform<T, UInt, infinity_bits, FloatOrder::total_order>());
+}
+
+inline void radix_sort(float* array, size_t size, float* temp, FloatOrder order)
+{
+    radix_sort_float_impl<float, uint32_t, float_infinity_bits>(array, size, temp, order);
+}
+
+inline void radix_sort(double* array, size_t size, double* temp)
+{
+    radix_sort_64_impl(array, size, temp, key_transform<double>());
+}
+
+inline void radix_sort(double* array, size_t size, double* temp, FloatOrder order)
+{
+    radix_sort_float_impl<double, uint64_t, double_infinity_bits>(array, size, temp, order);
+}
+
+#ifdef RADIX_SORT_HAS_FLOAT16
+inline void radix_sort(_Float16* array, size_t size, _Float16* temp)
+{
+    radix_sort_16_impl(array, size, temp, key_transform<_Float16>());
+}
+
+inline void radix_sort(_Float16* array, size_t size, _Float16* temp, FloatOrder order)
+{
+    radix_sort_float_impl<_Float16, uint16_t, float16_infinity_bits>(array, size, temp, order);
+}
+#endif
+
+#ifdef RADIX_SORT_HAS_BFLOAT16
+inline void radix_sort(std::bfloat16_t* array, size_t size, std::bfloat16_t* temp)
+{
+    radix_sort_16_impl(array, size, temp, key_transform<std::bfloat16_t>());
+}
+
+inline void radix_sort(std::bfloat16_t* array, size_t size, std::bfloat16_t* temp, FloatOrder order)
+{
+    radix_sort_float_impl<std::bfloat16_t, uint16_t, bfloat16_infinity_bits>(array, size, temp, order);
+}
+#endif
+
+// Sort IEEE 754 half precision (binary16) and bfloat16 numbers stored as their raw bits,
+// for compilers and code bases without a native 16 bit floating point type.
+inline void radix_sort_float16(uint16_t* array, size_t size, uint16_t* temp,
+                               FloatOrder order = FloatOrder::total_order)
+{
+    radix_sort_float_impl<uint16_t, uint16_t, float16_infinity_bits>(array, size, temp, order);
+}
+
+inline void radix_sort_bfloat16(uint16_t* array, size_t size, uint16_t* temp,
+                                FloatOrder order = FloatOrder::total_order)
+{
+    radix_sort_float_impl<uint16_t, uint16_t, bfloat16_infinity_bits>(array, size, temp, order);
+}
+
+void radix_sort(uint8_t * array, size_t size)
+{    
+    size_t frequencies[1 << CHAR_BIT] = { 0 };
+
+    counting_sort_histogram_8(array, size, frequencies);
+    counting_sort_ends(frequencies, 1 << CHAR_BIT);
+    counting_sort_fill(array, 0, size, frequencies, 0, uint8_t(0));
+}
+
+void radix_sort(int8_t * array, size_t size)
+{
+    size_t frequencies[1 << CHAR_BIT] = { 0 };
+
+    counting_sort_histogram_8(array, size, frequencies);
+    counting_sort_ends(frequencies, 1 << CHAR_BIT);
+    counting_sort_fill(array, 0, size, frequencies, 0, std::numeric_limits<int8_t>::min());
+}
+
+// 16 bit arrays large enough to be sorted by counting need no temporary buffer.
+inline void radix_sort(uint16_t* array, size_t size)
+{
+    if (size >= counting_sort_threshold)
+    {
+        counting_sort_16(array, size);
+        return;
+    }
+
+    std::vector<uint16_t> temp(size);
+    radix_sort_16_impl(array, size, temp.data(), key_transform<uint16_t>());
+}
+
+inline void radix_sort(int16_t* array, size_t size)
+{
+    if (size >= counting_sort_threshold)
+    {
+        counting_sort_16(array, size);
+        return;
+    }
+
+    std::vector<int16_t> temp(size);
+    radix_sort_16_impl(array, size, temp.data(), key_transform<int16_t>());
+}
+
+template <typename T>
+void radix_sort(T* array, size_t size)
+{
+    T * temp = new T[size];
+    radix_sort(array, size, temp);
+    delete[] temp;
+}
+
+template <typename T>
+void radix_sort(T* array, size_t size, FloatOrder order)
+{
+    T * temp = new T[size];
+    radix_sort(array, size, temp, order);
+    delete[] temp;
+}
+
+template <typename T>
+void radix_sort(T* array, size_t size, Workspace& workspace)
+{
+    radix_sort(array, size, workspace.scratch<T>(size));
+}
+
+template <typename T>
+void radix_sort(T* array, size_t size, Workspace& workspace, FloatOrder order)
+{
+    radix_sort(array, size, workspace.scratch<T>(size), order);
+}
+
+inline void radix_sort(uint8_t* array, size_t size, Workspace&)
+{
+    radix_sort(array, size);
+}
+
+inline void radix_sort(int8_t* array, size_t size, Workspace&)
+{
+    radix_sort(array, size);
+}
+
+inline void radix_sort(uint16_t* array, size_t size, Workspace& workspace)
+{
+    if (size >= counting_sort_threshold)
+        counting_sort_impl(array, size, workspace.tables(counting_sort_buckets<uint16_t>()),
+                           counting_sort_buckets<uint16_t>(), uint16_t(0));
+    else
+        radix_sort_16_impl(array, size, workspace.scratch<uint16_t>(size), key_transform<uint16_t>());
+}
+
+inline void radix_sort(int16_t* array, size_t size, Workspace& workspace)
+{
+    if (size >= counting_sort_threshold)
+        counting_sort_impl(array, size, workspace.tables(counting_sort_buckets<int16_t>()),
+                           counting_sort_buckets<int16_t>(), std::numeric_limits<int16_t>::min());
+    else
+        radix_sort_16_impl(array, size, workspace.scratch<int16_t>(size), key_transform<int16_t>());
+}
+
+// Sorts integers that are all known to lie in [min_value, max_value] by counting: one pass
+// to count and one to write, no temporary buffer. Falls back to radix_sort when the range
+// has more than counting_sort_max_buckets values or more values than twice the array
+// has elements, where scanning the buckets would cost more than the passes it saves.
+template <typename T>
+void radix_sort_counting(T* array, size_t size, T min_value, T max_value)
+{
+    static_assert(std::is_integral<T>::value, "radix_sort_counting sorts integers");
+
+    const size_t range = counting_bucket(max_value, min_value);
+
+    if (range >= counting_sort_max_buckets || range / 2 >= size)
+    {
+        radix_sort(array, size);
+        return;
+    }
+
+    if (size <= std::numeric_limits<uint32_t>::max())
+    {
+        std::vector<uint32_t> counts(range + 1);
+        counting_sort_impl(array, size, counts.data(), range + 1, min_value);
+    }
+    else
+    {
+        std::vector<size_t> counts(range + 1);
+        counting_sort_impl(array, size, counts.data(), range + 1, min_value);
+    }
+}
+
+inline void radix_sort_float16(uint16_t* array, size_t size, FloatOrder order = FloatOrder::total_order)
+{
+    uint16_t * temp = new uint16_t[size];
+    radix_sort_float16(array, size, temp, order);
+    delete[] temp;
+}
+
+inline void radix_sort_bfloat16(uint16_t* array, size_t size, FloatOrder order = FloatOrder::total_order)
+{
+    uint16_t * temp = new uint16_t[size];
+    radix_sort_bfloat16(array, size, temp, order);
+    delete[] temp;
+}
+
+inline void radix_sort_float16(uint16_t* array, size_t size, Workspace& workspace,
+                               FloatOrder order = FloatOrder::total_order)
+{
+    radix_sort_float16(array, size, workspace.scratch<uint16_t>(size), order);
+}
+
+inline void radix_sort_bfloat16(uint16_t* array, size_t size, Workspace& workspace,
+                                FloatOrder order = FloatOrder::total_order)
+{
+    radix_sort_bfloat16(array, size, workspace.scratch<uint16_t>(size), order);
+}
+
+// radix_sort<DigitBits>(P, N, M): LSD radix sort with DigitBits wide digits, e.g.
+// radix_sort<11> sorts 32 bit keys in 3 passes and 64 bit keys in 6.
+template <unsigned DigitBits, typename T>
+void radix_sort(T* array, size_t size, T* temp)
+{
+    radix_sort_lsd_impl<DigitBits>(array, size, temp, key_transform<T>());
+}
+
+template <unsigned DigitBits, typename T>
+void radix_sort(T* array, size_t size)
+{
+    T * temp = new T[size];
+    radix_sort<DigitBits>(array, size, temp);
+    delete[] temp;
+}
+
+template <unsigned DigitBits, typename T>
+void radix_sort(T* array, size_t size, Workspace& workspace)
+{
+    using Ret = decltype(key_transform<T>()(std::declval<T&>()));
+
+    size_t* frequencies = workspace.tables(lsd_histogram_size(sizeof(Ret), DigitBits));
+
+    radix_sort_lsd_impl<DigitBits>(array, size, workspace.scratch<T>(size), key_transform<T>(), frequencies);
+}
+
+// Bit transform of a key projection: maps an element to key_func(element), then to the
+// unsigned integer whose order matches the order of that key.
+template <typename T, typename KeyFunc>
+struct projected_key_transform
+{
+    using key_type = typename std::decay<decltype(std::declval<KeyFunc&>()(std::declval<const T&>()))>::type;
+    using result_type = decltype(key_transform<key_type>()(std::declval<key_type>()));
+
+    KeyFunc key_func;
+
+    result_type operator()(const T& value) const
+    {
+        return key_transform<key_type>()(key_func(value));
+    }
+};
+
+// One element of an indirect sort: the transformed key of a record and its position.
+template <typename Ret, typename I>
+struct indirect_entry
+{
+    Ret key;
+    I index;
+};
+
+template <typename Ret, typename I>
+struct indirect_entry_key
+{
+    Ret operator()(const indirect_entry<Ret, I>& entry) const
+    {
+        return entry.key;
+    }
+};
+
+// Records at least this many times larger than their (key, index) entry are sorted
+// indirectly by the key projection overloads of radix_sort. Measured crossover: 24 byte
+// records with 32 bit keys, 32 to 48 byte records with 64 bit keys.
+const size_t indirect_sort_ratio = 3;
+
+template <typename T, typename F, typename I>
+struct sorts_indirectly : std::integral_constant<bool,
+    sizeof(T) >= indirect_sort_ratio * sizeof(indirect_entry<decltype(std::declval<F&>()(std::declval<T&>())), I>)>
+{
+};
+
+// Sorts (key, index) entries of the records instead of the records, so that every LSD pass
+// moves sizeof(entry) bytes per record instead of sizeof(T). entries must hold 2 * size
+// elements; afterwards entries[i].index is the position of the i-th record in sorted order.
+template <typename T, typename F, typename Ret, typename I>
+void indirect_sort_entries(const T* array, size_t size, F bitwise_transform, indirect_entry<Ret, I>* entries)
+{
+    for (size_t i = 0; i < size; ++i)
+        entries[i] = indirect_entry<Ret, I>{ bitwise_transform(array[i]), I(i) };
+
+    radix_sort_impl(entries, size, entries + size, indirect_entry_key<Ret, I>());
+}
+
+// Moves every record to its sorted position in place, following each cycle of the
+// permutation once: one record is held aside per cycle and every other one is moved once.
+// Visited positions are marked by pointing their entry at themselves.
+template <typename T, typename Ret, typename I>
+void apply_permutation_in_place(T* array, size_t size, indirect_entry<Ret, I>* entries)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (size_t(entries[i].index) == i)
+            continue;
+
+        T held = std::move(array[i]);
+        size_t j = i;
+
+        for (;;)
+        {
+            const size_t k = size_t(entries[j].index);
+
+            entries[j].index = I(j);
+
+            if (k == i)
+                break;
+
+            array[j] = std::move(array[k]);
+            j = k;
+        }
+
+        array[j] = std::move(held);
+    }
+}
+
+// Whether buffer, with room for size records, can hold the 2 * size entries of their
+// indirect sort, with indices of either width. Only buffers of trivially copyable records
+// can: other records are live objects, which the entries would overwrite before the
+// records are assigned to them.
+template <typename T, typename Ret>
+bool holds_indirect_entries(const T* buffer)
+{
+    using Entry = indirect_entry<Ret, uint64_t>;
+
+    return std::is_trivially_copyable<T>::value &&
+           buffer && sizeof(T) >= 2 * sizeof(Entry) && reinterpret_cast<uintptr_t>(buffer) % alignof(Entry) == 0;
+}
+
+// buffer holds 2 * size entries, or is null and they are allocated.
+template <typename T, typename F, typename I>
+void radix_sort_indirect_impl(T* array, size_t size, F bitwise_transform, void* buffer)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    std::vector<indirect_entry<Ret, I>> storage;
+
+    indirect_entry<Ret, I>* entries = static_cast<indirect_entry<Ret, I>*>(buffer);
+
+    if (!entries)
+    {
+        storage.resize(2 * size);
+        entries = storage.data();
+    }
+
+    indirect_sort_entries(array, size, bitwise_transform, entries);
+    apply_permutation_in_place(array, size, entries);
+}
+
+// uint32_t indices while they are enough.
+template <typename T, typename F>
+void radix_sort_indirect_impl(T* array, size_t size, F bitwise_transform, void* buffer)
+{
+    if (size <= std::numeric_limits<uint32_t>::max())
+        radix_sort_indirect_impl<T, F, uint32_t>(array, size, bitwise_transform, buffer);
+    else
+        radix_sort_indirect_impl<T, F, uint64_t>(array, size, bitwise_transform, buffer);
+}
+
+// Writes the sorted records to out by gathering them, from the back: when the entries
+// are kept in out, record i only overwrites entries i and up, which are read already.
+template <typename T, typename F, typename I>
+void radix_sort_indirect_copy_impl(const T* array, size_t size, T* out, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    std::vector<indirect_entry<Ret, I>> storage;
+
+    indirect_entry<Ret, I>* entries = reinterpret_cast<indirect_entry<Ret, I>*>(out);
+
+    if (!holds_indirect_entries<T, Ret>(out))
+    {
+        storage.resize(2 * size);
+        entries = storage.data();
+    }
+
+    indirect_sort_entries(array, size, bitwise_transform, entries);
+
+    for (size_t i = size; i-- > 0;)
+    {
+        const size_t index = size_t(entries[i].index);
+        out[i] = array[index];
+    }
+}
+
+template <typename T, typename F>
+void radix_sort_indirect_copy_impl(const T* array, size_t size, T* out, F bitwise_transform)
+{
+    if (size <= std::numeric_limits<uint32_t>::max())
+        radix_sort_indirect_copy_impl<T, F, uint32_t>(array, size, out, bitwise_transform);
+    else
+        radix_sort_indirect_copy_impl<T, F, uint64_t>(array, size, out, bitwise_transform);
+}
+
+// Gathering the records into temp and copying them back is faster than following the
+// cycles in place: the gathers don't wait on each other, the steps of a cycle do.
+template <typename T, typename F>
+void radix_sort_projected(T* array, size_t size, T* temp, F bitwise_transform, std::true_type /* indirect */)
+{
+    radix_sort_indirect_copy_impl(array, size, temp, bitwise_transform);
+    std::copy(temp, temp + size, array);
+}
+
+template <typename T, typename F>
+void radix_sort_projected(T* array, size_t size, T* temp, F bitwise_transform, std::false_type /* indirect */)
+{
+    radix_sort_impl(array, size, temp, bitwise_transform);
+}
+
+// Sorts records by the key that key_func returns for them: any type radix_sort itself
+// supports (8 to 128 bit integers, float or byte arrays). The sort is stable. temp must hold at
+// least size elements. Records up to indirect_sort_ratio times the size of a (key, index)
+// entry are moved by every pass; larger ones are sorted indirectly, like
+// radix_sort_indirect_copy into temp, and copied back, which moves every record twice.
+template <typename T, typename KeyFunc,
+          typename = decltype(std::declval<KeyFunc&>()(std::declval<const T&>()))>
+void radix_sort(T* array, size_t size, T* temp, KeyFunc key_func)
+{
+    using F = projected_key_transform<T, KeyFunc>;
+
+    radix_sort_projected(array, size, temp, F{ key_func }, sorts_indirectly<T, F, uint32_t>());
+}
+
+template <typename T, typename KeyFunc,
+          typename = decltype(std::declval<KeyFunc&>()(std::declval<const T&>()))>
+void radix_sort(T* array, size_t size, KeyFunc key_func)
+{
+    T * temp = new T[size];
+    radix_sort(array, size, temp, key_func);
+    delete[] temp;
+}
+
+template <typename T, typename KeyFunc,
+          typename = decltype(std::declval<KeyFunc&>()(std::declval<const T&>()))>
+void radix_sort(T* array, size_t size, Workspace& workspace, KeyFunc key_func)
+{
+    // The scratch buffer holds no objects to assign records to, only bytes to copy them into.
+    if (std::is_trivially_copyable<T>::value)
+        radix_sort(array, size, workspace.scratch<T>(size), key_func);
+    else
+        radix_sort(array, size, key_func);
+}
+
+// radix_sort_indirect(P, N[, W], K): sorts records by key_func like radix_sort(P, N, K),
+// always indirectly and in place: the LSD passes sort an array of (key, 32 bit index)
+// entries, and then every record is moved once, to its sorted position, by following
+// the cycles of the permutation. Needs memory for 2 * N entries instead of N records,
+// but the steps of a cycle are dependent random accesses, so it is slower than
+// radix_sort_indirect_copy and than radix_sort, which gathers. Stable.
+template <typename T, typename KeyFunc,
+          typename = decltype(std::declval<KeyFunc&>()(std::declval<const T&>()))>
+void radix_sort_indirect(T* array, size_t size, KeyFunc key_func)
+{
+    radix_sort_indirect_impl(array, size, projected_key_transform<T, KeyFunc>{ key_func }, nullptr);
+}
+
+template <typename T, typename KeyFunc,
+          typename = decltype(std::declval<KeyFunc&>()(std::declval<const T&>()))>
+void radix_sort_indirect(T* array, size_t size, Workspace& workspace, KeyFunc key_func)
+{
+    using F = projected_key_transform<T, KeyFunc>;
+    using Ret = typename F::result_type;
+
+    radix_sort_indirect_impl(array, size, F{ key_func }, workspace.scratch<indirect_entry<Ret, uint64_t>>(2 * size));
+}
+
+// Writes the records of array sorted by key_func to out, which must not overlap array;
+// array is not modified. Sorts the entries like radix_sort_indirect, then gathers every
+// record once. Trivially copyable records at least twice as large as their entries keep
+// the entries in out instead of allocating them.
+template <typename T, typename KeyFunc,
+          typename = decltype(std::declval<KeyFunc&>()(std::declval<const T&>()))>
+void radix_sort_indirect_copy(const T* array, size_t size, T* out, KeyFunc key_func)
+{
+    radix_sort_indirect_copy_impl(array, size, out, projected_key_transform<T, KeyFunc>{ key_func });
+}
+
+// Segments of radix_sort_segmented shorter than this are sorted in batches. Longer
+// segments already amortize their own histograms and are sorted one by one.
+const size_t segment_batch_max_segment = 128;
+
+// Segments shorter than this are insertion sorted one by one instead: a batch costs one
+// pass per key byte plus one, which for a handful of elements loses to insertion sort.
+constexpr size_t segment_batch_min_segment(size_t key_size)
+{
+    return 6 * key_size;
+}
+
+// Maximum number of elements in one batch of segments. Small enough for the batch,
+// its copy and the segment ids to stay in L1 across all passes.
+const size_t segment_batch_size = size_t(1) << 11;
+
+// Sorts a run of consecutive segments as one array: the LSD passes sort the whole batch by
+// key, carrying every element's segment number along, and a final stable pass by segment
+// number puts each element back into its own segment. That pays for one histogram and one
+// set of offset tables per batch instead of per segment.
+// offsets are relative to array; temp must hold as many elements as the batch,
+// ids and ids_temp segment_batch_size entries, positions num_segments entries.
+template <typename T, typename F>
+void radix_sort_segment_batch(T* array, const size_t* offsets, size_t num_segments, T* temp,
+                              uint16_t* ids, uint16_t* ids_temp, size_t* positions, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    const size_t num_passes = sizeof(Ret);
+
+    const size_t base = offsets[0];
+    const size_t size = offsets[num_segments] - base;
+
+    size_t frequencies[num_passes][256] = { { 0 } };
+
+    radix_sort_histogram(array, size, frequencies, bitwise_transform);
+    radix_sort_calculate_offset_table(frequencies, std::integral_constant<size_t, num_passes>());
+
+    for (size_t segment = 0; segment < num_segments; ++segment)
+    {
+        for (size_t i = offsets[segment] - base; i < offsets[segment + 1] - base; ++i)
+        {
+            size_t i0 = frequencies[0][bitwise_transform(array[i]) & 255]++;
+            temp[i0] = array[i];
+            ids_temp[i0] = uint16_t(segment);
+        }
+    }
+
+    T* src = temp;
+    T* dst = array;
+    uint16_t* ids_src = ids_temp;
+    uint16_t* ids_dst = ids;
+
+    for (unsigned pass = 1; pass < num_passes; ++pass)
+    {
+        const unsigned shift = pass * CHAR_BIT;
+
+        auto extract_byte = [shift](Ret v) -> size_t
+        {
+            return (v >> shift) & 255;
+        };
+
+        copy_with_reordering_by_key(src, src + size, ids_src, dst, ids_dst, size, frequencies[pass],
+                                    extract_byte, bitwise_transform);
+
+        std::swap(src, dst);
+        std::swap(ids_src, ids_dst);
+    }
+
+    for (size_t segment = 0; segment < num_segments; ++segment)
+        positions[segment] = offsets[segment] - base;
+
+    for (size_t i = 0; i < size; ++i)
+        dst[positions[ids_src[i]]++] = src[i];
+
+    if (dst != array)
+        std::copy(dst, dst + size, array);
+}
+
+// ids must hold 2 * segment_batch_size entries, positions segment_batch_size entries.
+template <typename T, typename F>
+void radix_sort_segmented_impl(T* array, const size_t* offsets, size_t num_segments, T* temp,
+                               uint16_t* ids, size_t* positions, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    const size_t base = offsets[0];
+
+    auto batched = [offsets](size_t segment)
+    {
+        const size_t size = offsets[segment + 1] - offsets[segment];
+        return size >= segment_batch_min_segment(sizeof(Ret)) && size < segment_batch_max_segment;
+    };
+
+    size_t i = 0;
+
+    while (i < num_segments)
+    {
+        size_t j = i + 1;
+
+        if (batched(i))
+        {
+            while (j < num_segments && batched(j) &&
+                   offsets[j + 1] - offsets[i] <= segment_batch_size)
+            {
+                ++j;
+            }
+        }
+
+        if (j - i > 1)
+            radix_sort_segment_batch(array + offsets[i], offsets + i, j - i, temp + (offsets[i] - base),
+                                     ids, ids + segment_batch_size, positions, bitwise_transform);
+        else
+            radix_sort_impl(array + offsets[i], offsets[i + 1] - offsets[i], temp + (offsets[i] - base),
+                            bitwise_transform);
+
+        i = j;
+    }
+}
+
+// Sorts every segment [offsets[i], offsets[i + 1]) of array independently, for i < num_segments.
+// offsets must be non-decreasing and have num_segments + 1 entries.
+// temp must hold at least offsets[num_segments] - offsets[0] elements.
+template <typename T>
+void radix_sort_segmented(T* array, const size_t* offsets, size_t num_segments, T* temp)
+{
+    std::vector<uint16_t> ids(2 * segment_batch_size);
+    std::vector<size_t> positions(segment_batch_size);
+
+    radix_sort_segmented_impl(array, offsets, num_segments, temp, ids.data(), positions.data(),
+                              key_transform<T>());
+}
+
+template <typename T>
+void radix_sort_segmented(T* array, const size_t* offsets, size_t num_segments)
+{
+    if (num_segments == 0)
+        return;
+
+    T * temp = new T[offsets[num_segments] - offsets[0]];
+    radix_sort_segmented(array, offsets, num_segments, temp);
+    delete[] temp;
+}
+
+template <typename T>
+void radix_sort_segmented(T* array, const size_t* offsets, size_t num_segments, Workspace& workspace)
+{
+    if (num_segments == 0)
+        return;
+
+    std::pair<T*, uint16_t*> scratch =
+        workspace.scratch<T, uint16_t>(offsets[num_segments] - offsets[0], 2 * segment_batch_size);
+
+    radix_sort_segmented_impl(array, offsets, num_segments, scratch.first, scratch.second,
+                              workspace.tables(segment_batch_size), key_transform<T>());
+}
+
+// Runs task(0), ..., task(num_tasks - 1) concurrently, one std::thread per task,
+// and returns when all of them have finished. Any object with the same call
+// signature (e.g. a wrapper around an existing thread pool) can be passed to
+// radix_sort_parallel instead.
+struct ThreadExecutor
+{
+    template <typename F>
+    void operator()(size_t num_tasks, F task) const
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(num_tasks);
+
+        for (size_t i = 1; i < num_tasks; ++i)
+            threads.emplace_back(task, i);
+
+        task(size_t(0));
+
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+};
+
+// Chunks smaller than this are not worth a thread of their own.
+const size_t parallel_min_chunk_size = size_t(1) << 16;
+
+template<typename T, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
+void count_bytes(T* array, T* array_end, size_t* freq,
+                 ExtractByteFuncT extract_byte_f,
+                 BitwiseTransformFuncT bitwise_transform_f)
+{
+    size_t unroll_size = (array_end - array) >> 2;
+
+    T* p = array;
+
+    for (; unroll_size; --unroll_size, p += 4)
+    {
+        freq[extract_byte_f(bitwise_transform_f(*p))]++;
+        freq[extract_byte_f(bitwise_transform_f(*(p+1)))]++;
+        freq[extract_byte_f(bitwise_transform_f(*(p+2)))]++;
+        freq[extract_byte_f(bitwise_transform_f(*(p+3)))]++;
+    }
+
+    for (; p != array_end; ++p)
+        freq[extract_byte_f(bitwise_transform_f(*p))]++;
+}
+
+// freq holds num_chunks consecutive num_buckets-entry histograms, one per chunk.
+// Replaces them with the starting offset of every (bucket, chunk) pair, so that
+// each chunk scatters into its own slice of every bucket and the sort stays stable.
+inline void radix_sort_calculate_offset_table_parallel(size_t* freq, size_t num_chunks, size_t num_buckets = 256)
+{
+    size_t offset = 0;
+
+    for (size_t i = 0; i < num_buckets; ++i)
+    {
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            size_t temp_offset = freq[chunk * num_buckets + i] + offset;
+            freq[chunk * num_buckets + i] = offset;
+            offset = temp_offset;
+        }
+    }
+}
+
+// frequencies must hold 256 * max(num_threads, 1) entries.
+template <typename T, typename F, typename Executor>
+void radix_sort_parallel_impl(T* array, size_t size, T* temp, F bitwise_transform,
+                              size_t num_threads, Executor& executor, size_t* frequencies)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    static_assert(sizeof(Ret) % 2 == 0, "Even number of passes expected, the result must end up in array");
+
+    size_t num_chunks = std::min(num_threads, size / parallel_min_chunk_size);
+
+    if (num_chunks < 2)
+    {
+        num_chunks = 1;
+    }
+
+    const size_t chunk_size = size / num_chunks;
+
+    T* src = array;
+    T* dst = temp;
+
+    for (unsigned pass = 0; pass < sizeof(Ret); ++pass)
+    {
+        const unsigned shift = pass * CHAR_BIT;
+
+        auto extract_byte = [shift](Ret v) -> size_t
+        {
+            return (v >> shift) & 255;
+        };
+
+        std::fill(frequencies, frequencies + num_chunks * 256, size_t(0));
+
+        executor(num_chunks, [&](size_t chunk)
+        {
+            T* begin = src + chunk * chunk_size;
+            T* end = chunk + 1 == num_chunks ? src + size : begin + chunk_size;
+
+            count_bytes(begin, end, &frequencies[chunk * 256], extract_byte, bitwise_transform);
+        });
+
+        radix_sort_calculate_offset_table_parallel(frequencies, num_chunks);
+
+        executor(num_chunks, [&](size_t chunk)
+        {
+            T* begin = src + chunk * chunk_size;
+            T* end = chunk + 1 == num_chunks ? src + size : begin + chunk_size;
+
+            copy_with_reordering(begin, end, dst, end - begin, &frequencies[chunk * 256],
+                                 extract_byte, bitwise_transform);
+        });
+
+        std::swap(src, dst);
+    }
+}
+
+// Counting sort with one histogram per chunk, counted concurrently. The histograms are
+// then summed bucket range by bucket range, and the output is split into equal slices
+// that are filled concurrently, so skewed keys don't leave one thread doing all the writes.
+// counts must hold counting_sort_buckets<T>() * max(num_threads, 1) entries.
+template <typename T, typename Executor>
+void counting_sort_parallel_impl(T* array, size_t size, size_t num_threads, Executor& executor, size_t* counts)
+{
+    const size_t num_buckets = counting_sort_buckets<T>();
+    const T min_value = std::numeric_limits<T>::min();
+
+    size_t num_chunks = std::min(num_threads, size / parallel_min_chunk_size);
+
+    if (num_chunks < 2)
+    {
+        num_chunks = 1;
+    }
+
+    const size_t chunk_size = size / num_chunks;
+    const size_t buckets_per_chunk = num_buckets / num_chunks;
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        const T* begin = array + chunk * chunk_size;
+        const T* end = chunk + 1 == num_chunks ? array + size : begin + chunk_size;
+
+        size_t* chunk_counts = counts + chunk * num_buckets;
+
+        std::fill(chunk_counts, chunk_counts + num_buckets, size_t(0));
+        counting_sort_histogram(begin, size_t(end - begin), chunk_counts, min_value);
+    });
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        const size_t first = chunk * buckets_per_chunk;
+        const size_t last = chunk + 1 == num_chunks ? num_buckets : first + buckets_per_chunk;
+
+        for (size_t other = 1; other < num_chunks; ++other)
+        {
+            for (size_t bucket = first; bucket < last; ++bucket)
+                counts[bucket] += counts[other * num_buckets + bucket];
+        }
+    });
+
+    counting_sort_ends(counts, num_buckets);
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        const size_t position = chunk * chunk_size;
+        const size_t end = chunk + 1 == num_chunks ? size : position + chunk_size;
+
+        const size_t bucket = size_t(std::upper_bound(counts, counts + num_buckets, position) - counts);
+
+        counting_sort_fill(array, position, end, counts, bucket, min_value);
+    });
+}
+
+template <typename T>
+size_t parallel_table_size(size_t num_threads, std::false_type /* counting sort key */)
+{
+    return std::max(num_threads, size_t(1)) * 256;
+}
+
+template <typename T>
+size_t parallel_table_size(size_t num_threads, std::true_type /* counting sort key */)
+{
+    return std::max(num_threads, size_t(1)) * counting_sort_buckets<T>();
+}
+
+template <typename T, typename Executor>
+void radix_sort_parallel_dispatch(T* array, size_t size, T* temp, size_t num_threads, Executor& executor,
+                                  size_t* frequencies, std::false_type /* counting sort key */)
+{
+    radix_sort_parallel_impl(array, size, temp, key_transform<T>(), num_threads, executor, frequencies);
+}
+
+template <typename T, typename Executor>
+void radix_sort_parallel_dispatch(T* array, size_t size, T* temp, size_t num_threads, Executor& executor,
+                                  size_t* frequencies, std::true_type /* counting sort key */)
+{
+    if (counting_sort_pays_off<T>(size))
+        counting_sort_parallel_impl(array, size, num_threads, executor, frequencies);
+    else
+        radix_sort_impl(array, size, temp, key_transform<T>());
+}
+
+// 8 and 16 bit keys are sorted by counting, with the histograms counted in parallel,
+// and don't use temp once they are large enough.
+template <typename T, typename Executor>
+void radix_sort_parallel(T* array, size_t size, T* temp, size_t num_threads, Executor& executor)
+{
+    std::vector<size_t> frequencies(parallel_table_size<T>(num_threads, is_counting_sort_key<T>()));
+
+    radix_sort_parallel_dispatch(array, size, temp, num_threads, executor, frequencies.data(),
+                                 is_counting_sort_key<T>());
+}
+
+template <typename T, typename Executor>
+void radix_sort_parallel(T* array, size_t size, Workspace& workspace, size_t num_threads, Executor& executor)
+{
+    size_t* frequencies = workspace.tables(parallel_table_size<T>(num_threads, is_counting_sort_key<T>()));
+
+    T* temp = counting_sort_pays_off<T>(size) ? nullptr : workspace.scratch<T>(size);
+
+    radix_sort_parallel_dispatch(array, size, temp, num_threads, executor, frequencies, is_counting_sort_key<T>());
+}
+
+template <typename T>
+void radix_sort_parallel(T* array, size_t size, Workspace& workspace,
+                         size_t num_threads = std::thread::hardware_concurrency())
+{
+    ThreadExecutor executor;
+    radix_sort_parallel(array, size, workspace, num_threads, executor);
+}
+
+template <typename T>
+void radix_sort_parallel(T* array, size_t size, T* temp, size_t num_threads)
+{
+    ThreadExecutor executor;
+    radix_sort_parallel(array, size, temp, num_threads, executor);
+}
+
+template <typename T>
+void radix_sort_parallel(T* array, size_t size, size_t num_threads = std::thread::hardware_concurrency())
+{
+    T * temp = counting_sort_pays_off<T>(size) ? nullptr : new T[size];
+    radix_sort_parallel(array, size, temp, num_threads);
+    delete[] temp;
+}
+
+// Arrays of at least this many bytes are sorted by radix_sort_hybrid with MSD passes
+// first; smaller ones are sorted by the LSD engine directly.
+const size_t hybrid_sort_threshold_bytes = size_t(1) << 25;
+
+// MSD buckets of at most this many bytes are finished by the LSD engine: the bucket and
+// its part of the other buffer then stay in L2 or L3 across all its passes.
+const size_t hybrid_bucket_bytes = size_t(1) << 21;
+
+// Sorts one MSD bucket of radix_sort_hybrid. The bucket is in data, other is the same
+// range of the other buffer and in_array tells which of the two is part of the array,
+// where the result has to end up. Bytes digits and up are equal across the bucket.
+// A bucket that doesn't fit the cache yet is split again by byte digits - 1.
+template <typename T, typename F>
+void hybrid_sort_bucket(T* data, T* other, size_t size, unsigned digits, bool in_array, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    if (digits == 0 || size * sizeof(T) <= hybrid_bucket_bytes)
+    {
+        radix_sort_impl(data, size, other, bitwise_transform);
+
+        // The bucket was just sorted, copying it while it is cached costs little.
+        if (!in_array)
+            std::copy(data, data + size, other);
+
+        return;
+    }
+
+    const unsigned shift = (digits - 1) * CHAR_BIT;
+
+    auto extract_byte = [shift](Ret v) -> size_t
+    {
+        return (v >> shift) & 255;
+    };
+
+    size_t freq[256] = { 0 };
+
+    count_bytes(data, data + size, freq, extract_byte, bitwise_transform);
+
+    // All elements share this byte too: split by the next one without moving anything.
+    if (freq[extract_byte(bitwise_transform(data[0]))] == size)
+    {
+        hybrid_sort_bucket(data, other, size, digits - 1, in_array, bitwise_transform);
+        return;
+    }
+
+    size_t begins[257];
+
+    begins[0] = 0;
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        begins[i + 1] = begins[i] + freq[i];
+        freq[i] = begins[i];
+    }
+
+    copy_with_reordering(data, data + size, other, size, freq, extract_byte, bitwise_transform);
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        if (begins[i + 1] != begins[i])
+            hybrid_sort_bucket(other + begins[i], data + begins[i], begins[i + 1] - begins[i], digits - 1,
+                               !in_array, bitwise_transform);
+    }
+}
+
+// Hybrid MSD/LSD radix sort for arrays much larger than the last level cache, where every
+// LSD pass streams the whole array through DRAM twice. One MSD pass on the most significant
+// byte that isn't the same for all elements scatters the array into temp, and every bucket
+// that is still larger than hybrid_bucket_bytes is split again by the next byte. Each
+// bucket is then sorted by the LSD engine while it stays in the cache, where its higher
+// bytes are all equal and take no pass. The first pass is counted and scattered by
+// num_threads chunks like radix_sort_parallel, then the buckets are independent and are
+// handed out to num_threads tasks, largest first. Stable.
+// frequencies must hold 256 * max(num_threads, 1) zeroed counters.
+template <typename T, typename F, typename Executor>
+void radix_sort_hybrid_impl(T* array, size_t size, T* temp, F bitwise_transform,
+                            size_t num_threads, Executor& executor, size_t* frequencies)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    const size_t num_bytes = sizeof(Ret);
+
+    if (num_bytes < 4 || size * sizeof(T) < hybrid_sort_threshold_bytes)
+    {
+        radix_sort_impl(array, size, temp, bitwise_transform);
+        return;
+    }
+
+    if (presorted_prefix(array, size, bitwise_transform) == size)
+        return;
+
+    size_t num_chunks = std::min(num_threads, size / parallel_min_chunk_size);
+
+    if (num_chunks < 2)
+    {
+        num_chunks = 1;
+    }
+
+    const size_t chunk_size = size / num_chunks;
+
+    // The bits in which some element differs from the first one. A full histogram of
+    // every byte would tell the same, but costs many times this pass.
+    const Ret first = bitwise_transform(array[0]);
+
+    std::vector<Ret> differing(num_chunks);
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        T* begin = array + chunk * chunk_size;
+        T* end = chunk + 1 == num_chunks ? array + size : begin + chunk_size;
+
+        Ret bits = 0;
+
+        for (T* p = begin; p != end; ++p)
+            bits |= bitwise_transform(*p) ^ first;
+
+        differing[chunk] = bits;
+    });
+
+    Ret bits = 0;
+
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk)
+        bits |= differing[chunk];
+
+    // Not sorted, so some bit differs. The first pass splits by the highest byte that does.
+    unsigned digits = num_bytes;
+
+    while ((bits >> ((digits - 1) * CHAR_BIT)) == 0)
+        --digits;
+
+    const unsigned shift = (digits - 1) * CHAR_BIT;
+
+    auto extract_byte = [shift](Ret v) -> size_t
+    {
+        return (v >> shift) & 255;
+    };
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        T* begin = array + chunk * chunk_size;
+        T* end = chunk + 1 == num_chunks ? array + size : begin + chunk_size;
+
+        count_bytes(begin, end, frequencies + chunk * 256, extract_byte, bitwise_transform);
+    });
+
+    radix_sort_calculate_offset_table_parallel(frequencies, num_chunks);
+
+    // Where every bucket starts, before the offsets of the first chunk move on.
+    size_t begins[257];
+
+    std::copy(frequencies, frequencies + 256, begins);
+    begins[256] = size;
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        T* begin = array + chunk * chunk_size;
+        T* end = chunk + 1 == num_chunks ? array + size : begin + chunk_size;
+
+        copy_with_reordering(begin, end, temp, size_t(end - begin), frequencies + chunk * 256,
+                             extract_byte, bitwise_transform);
+    });
+
+    size_t order[256];
+    size_t num_buckets = 0;
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        if (begins[i + 1] != begins[i])
+            order[num_buckets++] = i;
+    }
+
+    std::sort(order, order + num_buckets, [&begins](size_t a, size_t b)
+    {
+        return begins[a + 1] - begins[a] > begins[b + 1] - begins[b];
+    });
+
+    std::atomic<size_t> next(0);
+
+    executor(std::min(std::max(num_threads, size_t(1)), num_buckets), [&](size_t)
+    {
+        for (size_t i = next++; i < num_buckets; i = next++)
+        {
+            const size_t b = order[i];
+
+            hybrid_sort_bucket(temp + begins[b], array + begins[b], begins[b + 1] - begins[b], digits - 1,
+                               false, bitwise_transform);
+        }
+    });
+}
+
+// radix_sort_hybrid(P, N[, M | W][, threads[, executor]]): radix sort for arrays that are
+// much larger than the last level cache, see radix_sort_hybrid_impl. Single threaded
+// unless num_threads is given. Smaller arrays are sorted by radix_sort's LSD engine.
+template <typename T, typename Executor>
+void radix_sort_hybrid(T* array, size_t size, T* temp, size_t num_threads, Executor& executor)
+{
+    std::vector<size_t> frequencies(std::max(num_threads, size_t(1)) * 256);
+
+    radix_sort_hybrid_impl(array, size, temp, key_transform<T>(), num_threads, executor, frequencies.data());
+}
+
+template <typename T, typename Executor>
+void radix_sort_hybrid(T* array, size_t size, Workspace& workspace, size_t num_threads, Executor& executor)
+{
+    size_t* frequencies = workspace.tables(std::max(num_threads, size_t(1)) * 256);
+
+    radix_sort_hybrid_impl(array, size, workspace.scratch<T>(size), key_transform<T>(), num_threads, executor,
+                           frequencies);
+}
+
+template <typename T>
+void radix_sort_hybrid(T* array, size_t size, T* temp, size_t num_threads = 1)
+{
+    ThreadExecutor executor;
+    radix_sort_hybrid(array, size, temp, num_threads, executor);
+}
+
+template <typename T>
+void radix_sort_hybrid(T* array, size_t size, Workspace& workspace, size_t num_threads = 1)
+{
+    ThreadExecutor executor;
+    radix_sort_hybrid(array, size, workspace, num_threads, executor);
+}
+
+template <typename T>
+void radix_sort_hybrid(T* array, size_t size, size_t num_threads = 1)
+{
+    T * temp = new T[size];
+    radix_sort_hybrid(array, size, temp, num_threads);
+    delete[] temp;
+}
+
+template<typename K, typename V, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
+void copy_with_reordering_by_key(K* keys, K* keys_end, V* values, K* keys_temp, V* values_temp,
+                                 size_t size, size_t* freq,
+                                 ExtractByteFuncT extract_byte_f,
+                                 BitwiseTransformFuncT bitwise_transform_f)
+{
+    size_t unroll_size = size >> 2;
+
+    K* p = keys;
+    V* v = values;
+
+    for (; unroll_size; --unroll_size, p += 4, v += 4)
+    {
+        size_t i0 = freq[extract_byte_f(bitwise_transform_f(*p))]++;
+        keys_temp[i0] = *p;
+        values_temp[i0] = *v;
+
+        size_t i1 = freq[extract_byte_f(bitwise_transform_f(*(p+1)))]++;
+        keys_temp[i1] = *(p+1);
+        values_temp[i1] = *(v+1);
+
+        size_t i2 = freq[extract_byte_f(bitwise_transform_f(*(p+2)))]++;
+        keys_temp[i2] = *(p+2);
+        values_temp[i2] = *(v+2);
+
+        size_t i3 = freq[extract_byte_f(bitwise_transform_f(*(p+3)))]++;
+        keys_temp[i3] = *(p+3);
+        values_temp[i3] = *(v+3);
+    }
+
+    for (; p != keys_end; ++p, ++v)
+    {
+        size_t i0 = freq[extract_byte_f(bitwise_transform_f(*p))]++;
+        keys_temp[i0] = *p;
+        values_temp[i0] = *v;
+    }
+}
+
+// Same as copy_with_reordering_by_key, but the value of every key is its position
+// in the original array. Used for the first pass of radix_argsort.
+template<typename K, typename I, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
+void copy_with_reordering_indexed(const K* keys, size_t size, K* keys_temp, I* indices_temp, size_t* freq,
+                                  ExtractByteFuncT extract_byte_f,
+                                  BitwiseTransformFuncT bitwise_transform_f)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        size_t i0 = freq[extract_byte_f(bitwise_transform_f(keys[i]))]++;
+        keys_temp[i0] = keys[i];
+        indices_temp[i0] = I(i);
+    }
+}
+
+template <typename K, typename V, typename F>
+void radix_sort_by_key_impl(K* keys, V* values, size_t size, K* keys_temp, V* values_temp,
+                            F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<K&>()));
+
+    const size_t num_passes = sizeof(Ret);
+
+    size_t frequencies[num_passes][256] = { { 0 } };
+
+    radix_sort_histogram(keys, size, frequencies, bitwise_transform);
+
+    // A byte in which all keys fall into the same bucket needs no pass.
+    bool skip[num_passes];
+
+    for (unsigned pass = 0; pass < num_passes; ++pass)
+        skip[pass] = size == 0 || frequencies[pass][(bitwise_transform(keys[0]) >> (pass * CHAR_BIT)) & 255] == size;
+
+    radix_sort_calculate_offset_table(frequencies, std::integral_constant<size_t, num_passes>());
+
+    K* keys_src = keys;
+    K* keys_dst = keys_temp;
+    V* values_src = values;
+    V* values_dst = values_temp;
+
+    for (unsigned pass = 0; pass < num_passes; ++pass)
+    {
+        if (skip[pass])
+            continue;
+
+        const unsigned shift = pass * CHAR_BIT;
+
+        auto extract_byte = [shift](Ret v) -> size_t
+        {
+            return (v >> shift) & 255;
+        };
+
+        copy_with_reordering_by_key(keys_src, keys_src + size, values_src, keys_dst, values_dst,
+                                    size, frequencies[pass], extract_byte, bitwise_transform);
+
+        std::swap(keys_src, keys_dst);
+        std::swap(values_src, values_dst);
+    }
+
+    if (keys_src != keys)
+    {
+        std::copy(keys_src, keys_src + size, keys);
+        std::copy(values_src, values_src + size, values);
+    }
+}
+
+template <typename K, typename I, typename F>
+void radix_argsort_impl(const K* keys, size_t size, I* indices, K* keys_temp, I* indices_temp,
+                        F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<K&>()));
+
+    const size_t num_passes = sizeof(Ret);
+
+    size_t frequencies[num_passes][256] = { { 0 } };
+
+    radix_sort_histogram(keys, size, frequencies, bitwise_transform);
+    radix_sort_calculate_offset_table(frequencies, std::integral_constant<size_t, num_passes>());
+
+    // Destinations alternate so that the last pass writes into indices.
+    K* keys_a = keys_temp;
+    K* keys_b = keys_temp + size;
+
+    K* keys_dst = num_passes % 2 ? keys_b : keys_a;
+    I* indices_dst = num_passes % 2 ? indices : indices_temp;
+
+    auto extract_byte_0 = [](Ret v) -> size_t
+    {
+        return v & 255;
+    };
+
+    copy_with_reordering_indexed(keys, size, keys_dst, indices_dst, frequencies[0],
+                                 extract_byte_0, bitwise_transform);
+
+    for (unsigned pass = 1; pass < num_passes; ++pass)
+    {
+        const unsigned shift = pass * CHAR_BIT;
+
+        auto extract_byte = [shift](Ret v) -> size_t
+        {
+            return (v >> shift) & 255;
+        };
+
+        K* keys_src = keys_dst;
+        I* indices_src = indices_dst;
+
+        keys_dst = keys_src == keys_a ? keys_b : keys_a;
+        indices_dst = indices_src == indices ? indices_temp : indices;
+
+        copy_with_reordering_by_key(keys_src, keys_src + size, indices_src, keys_dst, indices_dst,
+                                    size, frequencies[pass], extract_byte, bitwise_transform);
+    }
+}
+
+// Sorts keys and applies the same permutation to values (structure of arrays).
+// keys_temp and values_temp must hold at least size elements each.
+template <typename K, typename V>
+void radix_sort_by_key(K* keys, V* values, size_t size, K* keys_temp, V* values_temp)
+{
+    radix_sort_by_key_impl(keys, values, size, keys_temp, values_temp, key_transform<K>());
+}
+
+template <typename K, typename V>
+void radix_sort_by_key(K* keys, V* values, size_t size)
+{
+    K * keys_temp = new K[size];
+    V * values_temp = new V[size];
+    radix_sort_by_key(keys, values, size, keys_temp, values_temp);
+    delete[] values_temp;
+    delete[] keys_temp;
+}
+
+template <typename K, typename V>
+void radix_sort_by_key(K* keys, V* values, size_t size, Workspace& workspace)
+{
+    std::pair<K*, V*> scratch = workspace.scratch<K, V>(size, size);
+    radix_sort_by_key(keys, values, size, scratch.first, scratch.second);
+}
+
+// Writes into indices the stable permutation that sorts keys; keys are not modified.
+// I must be able to represent size - 1 (uint32_t is enough when size < 2^32).
+// keys_temp must hold at least 2 * size elements, indices_temp at least size elements.
+template <typename K, typename I>
+void radix_argsort(const K* keys, size_t size, I* indices, K* keys_temp, I* indices_temp)
+{
+    static_assert(std::is_integral<I>::value && std::is_unsigned<I>::value, "Indices must be unsigned integers");
+
+    radix_argsort_impl(keys, size, indices, keys_temp, indices_temp, key_transform<K>());
+}
+
+template <typename K, typename I>
+void radix_argsort(const K* keys, size_t size, I* indices)
+{
+    K * keys_temp = new K[2 * size];
+    I * indices_temp = new I[size];
+    radix_argsort(keys, size, indices, keys_temp, indices_temp);
+    delete[] indices_temp;
+    delete[] keys_temp;
+}
+
+template <typename K, typename I>
+void radix_argsort(const K* keys, size_t size, I* indices, Workspace& workspace)
+{
+    std::pair<K*, I*> scratch = workspace.scratch<K, I>(2 * size, size);
+    radix_argsort(keys, size, indices, scratch.first, scratch.second);
+}
+
+// Order of one column of a multi-column sort.
+enum class SortOrder
+{
+    ascending,
+    descending
+};
+
+// Key types a SortColumn can hold.
+enum class ColumnType
+{
+    uint8, int8, uint16, int16, uint32, int32, uint64, int64, float32, float64
+};
+
+template <typename T> struct column_type;
+template <> struct column_type<uint8_t> : std::integral_constant<ColumnType, ColumnType::uint8> {};
+template <> struct column_type<int8_t> : std::integral_constant<ColumnType, ColumnType::int8> {};
+template <> struct column_type<uint16_t> : std::integral_constant<ColumnType, ColumnType::uint16> {};
+template <> struct column_type<int16_t> : std::integral_constant<ColumnType, ColumnType::int16> {};
+template <> struct column_type<uint32_t> : std::integral_constant<ColumnType, ColumnType::uint32> {};
+template <> struct column_type<int32_t> : std::integral_constant<ColumnType, ColumnType::int32> {};
+template <> struct column_type<uint64_t> : std::integral_constant<ColumnType, ColumnType::uint64> {};
+template <> struct column_type<int64_t> : std::integral_constant<ColumnType, ColumnType::int64> {};
+template <> struct column_type<float> : std::integral_constant<ColumnType, ColumnType::float32> {};
+template <> struct column_type<double> : std::integral_constant<ColumnType, ColumnType::float64> {};
+
+// One column of a table stored column by column, with the order to sort it in.
+// Made with sort_column(pointer[, order]).
+struct SortColumn
+{
+    ColumnType type;
+    void* data;
+    SortOrder order;
+};
+
+template <typename T>
+SortColumn sort_column(T* data, SortOrder order = SortOrder::ascending)
+{
+    return SortColumn{ column_type<T>::value, data, order };
+}
+
+// Calls f(pointer) with the column's data as a pointer to its own type.
+template <typename F>
+void visit_column(const SortColumn& column, F& f)
+{
+    switch (column.type)
+    {
+    case ColumnType::uint8: f(static_cast<uint8_t*>(column.data)); break;
+    case ColumnType::int8: f(static_cast<int8_t*>(column.data)); break;
+    case ColumnType::uint16: f(static_cast<uint16_t*>(column.data)); break;
+    case ColumnType::int16: f(static_cast<int16_t*>(column.data)); break;
+    case ColumnType::uint32: f(static_cast<uint32_t*>(column.data)); break;
+    case ColumnType::int32: f(static_cast<int32_t*>(column.data)); break;
+    case ColumnType::uint64: f(static_cast<uint64_t*>(column.data)); break;
+    case ColumnType::int64: f(static_cast<int64_t*>(column.data)); break;
+    case ColumnType::float32: f(static_cast<float*>(column.data)); break;
+    case ColumnType::float64: f(static_cast<double*>(column.data)); break;
+    }
+}
+
+// Bit transform for descending order: the complement of the ascending one. Keys that
+// compare equal keep their order, so a descending column is still sorted stably.
+template <typename T>
+struct descending_key_transform
+{
+    using result_type = decltype(key_transform<T>()(std::declval<T&>()));
+
+    result_type operator()(const T& value) const
+    {
+        return result_type(~key_transform<T>()(value));
+    }
+};
+
+// Largest key of a set of columns, in bytes.
+struct column_key_size
+{
+    size_t bytes;
+
+    template <typename K>
+    void operator()(const K*)
+    {
+        bytes = std::max(bytes, sizeof(K));
+    }
+};
+
+// Bytes of scratch memory a multi-column sort of size rows needs besides its indices:
+// 2 * size keys and size indices for the widest column.
+template <typename I>
+size_t column_scratch_bytes(const SortColumn* columns, size_t num_columns, size_t size)
+{
+    column_key_size key_size{ 0 };
+
+    for (size_t column = 0; column < num_columns; ++column)
+        visit_column(columns[column], key_size);
+
+    const size_t keys_bytes = (2 * size * key_size.bytes + cache_line_size - 1) / cache_line_size * cache_line_size;
+
+    return keys_bytes + size * sizeof(I);
+}
+
+// One LSD step of radix_argsort_columns: gathers the column in the current row order
+// and stably sorts that copy, carrying the row numbers along. scratch holds
+// column_scratch_bytes and is cache line aligned.
+template <typename I>
+struct column_sort_step
+{
+    size_t size;
+    I* indices;
+    SortOrder order;
+    char* scratch;
+
+    template <typename K>
+    void operator()(const K* column) const
+    {
+        const size_t keys_bytes = (2 * size * sizeof(K) + cache_line_size - 1) / cache_line_size * cache_line_size;
+
+        K* keys = reinterpret_cast<K*>(scratch);
+        I* indices_temp = reinterpret_cast<I*>(scratch + keys_bytes);
+
+        for (size_t i = 0; i < size; ++i)
+            keys[i] = column[indices[i]];
+
+        if (order == SortOrder::descending)
+            radix_sort_by_key_impl(keys, indices, size, keys + size, indices_temp, descending_key_transform<K>());
+        else
+            radix_sort_by_key_impl(keys, indices, size, keys + size, indices_temp, key_transform<K>());
+    }
+};
+
+// Reorders a column by a row permutation: row i becomes the old row indices[i].
+// scratch holds size keys and is cache line aligned.
+template <typename I>
+struct column_permute
+{
+    size_t size;
+    const I* indices;
+    char* scratch;
+
+    template <typename K>
+    void operator()(K* column) const
+    {
+        K* temp = reinterpret_cast<K*>(scratch);
+
+        for (size_t i = 0; i < size; ++i)
+            temp[i] = column[indices[i]];
+
+        std::copy(temp, temp + size, column);
+    }
+};
+
+template <typename I>
+void radix_argsort_columns_impl(const SortColumn* columns, size_t num_columns, size_t size, I* indices,
+                                char* scratch)
+{
+    static_assert(std::is_integral<I>::value && std::is_unsigned<I>::value, "Indices must be unsigned integers");
+
+    for (size_t i = 0; i < size; ++i)
+        indices[i] = I(i);
+
+    for (size_t column = num_columns; column-- > 0;)
+    {
+        column_sort_step<I> step{ size, indices, columns[column].order, scratch };
+        visit_column(columns[column], step);
+    }
+}
+
+// Writes into indices the stable permutation that sorts the rows of a table stored column
+// by column, lexicographically by columns[0], then columns[1], and so on, each in its own
+// order. The columns are not modified. Runs one stable LSD sort per column, from the last
+// column to the first, on a copy of the column gathered in the current row order, so no
+// packed composite key and no comparisons are needed. Bytes that are the same in every row
+// of a column take no pass. I must be able to represent size - 1.
+template <typename I>
+void radix_argsort_columns(const SortColumn* columns, size_t num_columns, size_t size, I* indices,
+                           Workspace& workspace)
+{
+    char* scratch = workspace.scratch<char>(column_scratch_bytes<I>(columns, num_columns, size));
+
+    radix_argsort_columns_impl(columns, num_columns, size, indices, scratch);
+}
+
+template <typename I>
+void radix_argsort_columns(const SortColumn* columns, size_t num_columns, size_t size, I* indices)
+{
+    Workspace workspace;
+    radix_argsort_columns(columns, num_columns, size, indices, workspace);
+}
+
+// The indices are carved out of the workspace ahead of the scratch memory of the steps.
+template <typename I>
+void radix_sort_columns_impl(const SortColumn* columns, size_t num_columns, size_t size, Workspace& workspace)
+{
+    std::pair<I*, char*> scratch =
+        workspace.scratch<I, char>(size, column_scratch_bytes<I>(columns, num_columns, size));
+
+    radix_argsort_columns_impl(columns, num_columns, size, scratch.first, scratch.second);
+
+    column_permute<I> permute{ size, scratch.first, scratch.second };
+
+    for (size_t column = 0; column < num_columns; ++column)
+        visit_column(columns[column], permute);
+}
+
+// Sorts the rows of a table stored column by column in place: computes the permutation
+// with radix_argsort_columns and applies it to every column.
+inline void radix_sort_columns(const SortColumn* columns, size_t num_columns, size_t size, Workspace& workspace)
+{
+    if (size <= std::numeric_limits<uint32_t>::max())
+        radix_sort_columns_impl<uint32_t>(columns, num_columns, size, workspace);
+    else
+        radix_sort_columns_impl<uint64_t>(columns, num_columns, size, workspace);
+}
+
+inline void radix_sort_columns(const SortColumn* columns, size_t num_columns, size_t size)
+{
+    Workspace workspace;
+    radix_sort_columns(columns, num_columns, size, workspace);
+}
+
+// Buckets of the in-place MSD sort below this size are finished with a comparison sort.
+const size_t in_place_comparison_sort_threshold = 128;
+
+template <typename T, typename F>
+void radix_sort_in_place_impl(T* array, size_t size, unsigned byte_index, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    if (size < in_place_comparison_sort_threshold)
+    {
+        std::sort(array, array + size, [&bitwise_transform](const T& a, const T& b)
+        {
+            return bitwise_transform(a) < bitwise_transform(b);
+        });
+
+        return;
+    }
+
+    size_t ends[256];
+    size_t heads[256];
+
+    unsigned shift;
+
+    // Skip bytes in which all elements are equal.
+    for (;;)
+    {
+        shift = byte_index * CHAR_BIT;
+
+        std::fill(ends, ends + 256, size_t(0));
+
+        for (T* p = array; p != array + size; ++p)
+            ends[(bitwise_transform(*p) >> shift) & 255]++;
+
+        if (ends[(bitwise_transform(*array) >> shift) & 255] != size)
+            break;
+
+        if (byte_index == 0)
+            return;
+
+        --byte_index;
+    }
+
+    size_t offset = 0;
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        heads[i] = offset;
+        offset += ends[i];
+        ends[i] = offset;
+    }
+
+    auto extract_byte = [shift, &bitwise_transform](const T& v) -> size_t
+    {
+        return (Ret(bitwise_transform(v)) >> shift) & 255;
     };
 
-    radix_sort_32_impl(array, size, temp, flip_sign);
+    // American flag sort: follow each displacement cycle until the element that
+    // belongs to the current bucket is found.
+    for (size_t bucket = 0; bucket < 256; ++bucket)
+    {
+        while (heads[bucket] < ends[bucket])
+        {
+            T value = array[heads[bucket]];
+            size_t target = extract_byte(value);
+
+            while (target != bucket)
+            {
+                std::swap(value, array[heads[target]++]);
+                target = extract_byte(value);
+            }
+
+            array[heads[bucket]++] = value;
+        }
+    }
+
+    if (byte_index == 0)
+        return;
+
+    size_t begin = 0;
+
+    for (size_t bucket = 0; bucket < 256; ++bucket)
+    {
+        if (ends[bucket] - begin > 1)
+            radix_sort_in_place_impl(array + begin, ends[bucket] - begin, byte_index - 1, bitwise_transform);
+
+        begin = ends[bucket];
+    }
+}
+
+// In-place MSD radix sort (American flag sort). Needs no temporary buffer, only
+// O(256 * sizeof(T)) stack space, but unlike radix_sort it is not stable.
+template <typename T>
+void radix_sort_in_place(T* array, size_t size)
+{
+    using Ret = decltype(key_transform<T>()(T()));
+
+    if (size > 1)
+        radix_sort_in_place_impl(array, size, sizeof(Ret) - 1, key_transform<T>());
+}
+
+inline void radix_sort_in_place(uint8_t* array, size_t size)
+{
+    radix_sort(array, size);
+}
+
+inline void radix_sort_in_place(int8_t* array, size_t size)
+{
+    radix_sort(array, size);
+}
+
+// Ranges of radix_select shorter than this are finished with std::nth_element.
+const size_t select_comparison_threshold = 256;
+
+// MSD radix select: at every byte, from the most significant one down, only the bucket
+// that holds the k-th element is kept. The range is split into the elements below, in
+// and above that bucket, and the next byte is counted over the elements in it only,
+// so the range shrinks by up to 256 times per byte.
+template <typename T, typename F>
+void radix_select_impl(T* array, size_t size, size_t k, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    unsigned byte_index = sizeof(Ret);
+
+    while (byte_index > 0 && size >= select_comparison_threshold)
+    {
+        --byte_index;
+
+        const unsigned shift = byte_index * CHAR_BIT;
+
+        size_t frequencies[256] = { 0 };
+
+        for (T* p = array; p != array + size; ++p)
+            frequencies[(bitwise_transform(*p) >> shift) & 255]++;
+
+        size_t bucket = 0;
+        size_t below = 0;
+
+        while (below + frequencies[bucket] <= k)
+            below += frequencies[bucket++];
+
+        // All elements share this byte.
+        if (frequencies[bucket] == size)
+            continue;
+
+        auto side = [shift, bucket, &bitwise_transform](const T& v) -> size_t
+        {
+            size_t d = (Ret(bitwise_transform(v)) >> shift) & 255;
+            return d < bucket ? 0 : d == bucket ? 1 : 2;
+        };
+
+        // American flag sort with three buckets. Elements that are already on their
+        // side are not moved, which is most of them when the k-th bucket is skewed.
+        size_t heads[3] = { 0, below, below + frequencies[bucket] };
+        const size_t ends[3] = { heads[1], heads[2], size };
+
+        for (size_t part = 0; part < 2; ++part)
+        {
+            while (heads[part] < ends[part])
+            {
+                size_t target = side(array[heads[part]]);
+
+                if (target == part)
+                {
+                    ++heads[part];
+                    continue;
+                }
+
+                T value = array[heads[part]];
+
+                do
+                {
+                    while (side(array[heads[target]]) == target)
+                        ++heads[target];
+
+                    std::swap(value, array[heads[target]++]);
+                    target = side(value);
+                }
+                while (target != part);
+
+                array[heads[part]++] = value;
+            }
+        }
+
+        array += below;
+        size = frequencies[bucket];
+        k -= below;
+    }
+
+    // Once every byte has been consumed all elements left are equal.
+    if (byte_index > 0)
+    {
+        std::nth_element(array, array + k, array + size, [&bitwise_transform](const T& a, const T& b)
+        {
+            return bitwise_transform(a) < bitwise_transform(b);
+        });
+    }
+}
+
+// Rearranges array like std::nth_element: array[k] becomes the element that would be there
+// if array was sorted, no element before it is greater and no element after it is smaller.
+// k must be less than size. Needs no temporary buffer.
+template <typename T>
+void radix_select(T* array, size_t size, size_t k)
+{
+    radix_select_impl(array, size, k, key_transform<T>());
+}
+
+// Sorts the k smallest elements of array into array[0, k). The order of the rest is
+// unspecified. temp must hold at least k elements.
+template <typename T>
+void radix_partial_sort(T* array, size_t size, size_t k, T* temp)
+{
+    if (k < size)
+        radix_select(array, size, k);
+    else
+        k = size;
+
+    // 8 bit types have no radix_sort overload with a temp buffer.
+    radix_sort_impl(array, k, temp, key_transform<T>());
+}
+
+template <typename T>
+void radix_partial_sort(T* array, size_t size, size_t k)
+{
+    if (k < size)
+        radix_select(array, size, k);
+    else
+        k = size;
+
+    radix_sort(array, k);
+}
+
+template <typename T>
+void radix_partial_sort(T* array, size_t size, size_t k, Workspace& workspace)
+{
+    if (k < size)
+        radix_select(array, size, k);
+    else
+        k = size;
+
+    radix_sort(array, k, workspace);
+}
+
+// Sorts an array whose first sorted_size elements are already sorted, e.g. a sorted
+// column with new rows appended: only the tail is radix sorted, then it is merged into
+// the prefix. Stable. temp must hold at least size - sorted_size elements.
+template <typename T>
+void radix_sort_append(T* array, size_t size, size_t sorted_size, T* temp)
+{
+    radix_sort_impl(array + sorted_size, size - sorted_size, temp, key_transform<T>());
+    merge_sorted_tail(array, size, sorted_size, temp, key_transform<T>());
+}
+
+template <typename T>
+void radix_sort_append(T* array, size_t size, size_t sorted_size)
+{
+    T * temp = new T[size - sorted_size];
+    radix_sort_append(array, size, sorted_size, temp);
+    delete[] temp;
+}
+
+template <typename T>
+void radix_sort_append(T* array, size_t size, size_t sorted_size, Workspace& workspace)
+{
+    radix_sort_append(array, size, sorted_size, workspace.scratch<T>(size - sorted_size));
+}
+
+// Stable merge of the sorted runs a[0, a_size) and b[0, b_size) into out: on equal keys
+// the element of a goes first.
+template <typename T, typename F>
+void merge_runs(const T* a, size_t a_size, const T* b, size_t b_size, T* out, F bitwise_transform)
+{
+    const T* a_end = a + a_size;
+    const T* b_end = b + b_size;
+
+    while (a != a_end && b != b_end)
+    {
+        if (bitwise_transform(*b) < bitwise_transform(*a))
+            *out++ = *b++;
+        else
+            *out++ = *a++;
+    }
+
+    out = std::copy(a, a_end, out);
+    std::copy(b, b_end, out);
+}
+
+// Merge path: how many of the first diagonal elements of the stable merge of a and b
+// come from a, found by binary search along the diagonal.
+template <typename T, typename F>
+size_t merge_path_split(const T* a, size_t a_size, const T* b, size_t b_size, size_t diagonal,
+                        F bitwise_transform)
+{
+    size_t low = diagonal > b_size ? diagonal - b_size : 0;
+    size_t high = std::min(diagonal, a_size);
+
+    while (low < high)
+    {
+        const size_t mid = low + (high - low) / 2;
+
+        if (bitwise_transform(b[diagonal - mid - 1]) < bitwise_transform(a[mid]))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    return low;
+}
+
+// Number of elements of the sorted prefix array[0, sorted) that are not larger than the
+// first element of the sorted tail: they are in place already and take no part in the merge.
+template <typename T, typename F>
+size_t merge_untouched_prefix(const T* array, size_t size, size_t sorted, F bitwise_transform)
+{
+    if (sorted == size)
+        return sorted;
+
+    const auto first = bitwise_transform(array[sorted]);
+
+    size_t low = 0;
+    size_t high = sorted;
+
+    while (low < high)
+    {
+        const size_t mid = low + (high - low) / 2;
+
+        if (first < bitwise_transform(array[mid]))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    return low;
+}
+
+// Same result as merge_sorted_tail, merged in place by num_threads tasks. The output is
+// split into equal ranges, and merge_path_split finds the part of the prefix and of the
+// tail that each range is merged from. Task t writes [o_t, o_t+1) from the back, like
+// merge_sorted_tail, and so reads its prefix part [a_t, a_t+1) in place, except for the
+// head [a_t, o_t) that the ranges before it overwrite. The heads and the tail are copied
+// to temp first, which must hold size elements.
+template <typename T, typename F, typename Executor>
+void merge_sorted_tail_parallel(T* array, size_t size, size_t sorted, T* temp, size_t num_threads,
+                                Executor& executor, F bitwise_transform)
+{
+    if (sorted == 0 || sorted == size)
+        return;
+
+    size_t num_chunks = std::min(num_threads, size / parallel_min_chunk_size);
+
+    if (num_chunks < 2)
+    {
+        merge_sorted_tail(array, size, sorted, temp, bitwise_transform);
+        return;
+    }
+
+    const size_t tail = size - sorted;
+
+    // splits[t] prefix elements come before output position t * size / num_chunks.
+    std::vector<size_t> splits(num_chunks + 1);
+
+    for (size_t chunk = 0; chunk <= num_chunks; ++chunk)
+        splits[chunk] = merge_path_split(array, sorted, array + sorted, tail, chunk * size / num_chunks,
+                                         bitwise_transform);
+
+    T* tail_copy = temp;
+    T* heads = temp + tail;
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        const size_t out_begin = chunk * size / num_chunks;
+        const size_t a_begin = splits[chunk];
+        const size_t a_end = splits[chunk + 1];
+        const size_t b_begin = out_begin - a_begin;
+        const size_t b_end = (chunk + 1) * size / num_chunks - a_end;
+
+        std::copy(array + sorted + b_begin, array + sorted + b_end, tail_copy + b_begin);
+        std::copy(array + a_begin, array + std::min(out_begin, a_end), heads + a_begin);
+    });
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        const size_t out_begin = chunk * size / num_chunks;
+        const size_t a_begin = splits[chunk];
+        const size_t a_end = splits[chunk + 1];
+        const size_t b_begin = out_begin - a_begin;
+        const size_t b_end = (chunk + 1) * size / num_chunks - a_end;
+        const size_t head_end = std::min(out_begin, a_end);
+
+        T* out = array + out_begin + (a_end - a_begin) + (b_end - b_begin);
+        T* left = array + a_end;
+        const T* right = tail_copy + b_end;
+
+        while (left != array + head_end && right != tail_copy + b_begin)
+        {
+            if (bitwise_transform(*(right - 1)) < bitwise_transform(*(left - 1)))
+                *--out = *--left;
+            else
+                *--out = *--right;
+        }
+
+        std::copy_backward(array + head_end, left, out);
+
+        merge_runs(heads + a_begin, head_end - a_begin, tail_copy + b_begin, size_t(right - (tail_copy + b_begin)),
+                   array + out_begin, bitwise_transform);
+    });
+}
+
+// radix_sort_append_parallel(P, N, S[, M | W][, T[, E]]): radix_sort_append with the new
+// elements sorted by radix_sort_parallel and merged in place by T tasks. Only the part of
+// the prefix above the smallest new element takes part in the merge. M must hold N
+// elements; a Workspace grows to what the merge needs. Stable.
+template <typename T, typename Executor>
+void radix_sort_append_parallel(T* array, size_t size, size_t sorted_size, T* temp, size_t num_threads,
+                                Executor& executor)
+{
+    radix_sort_parallel(array + sorted_size, size - sorted_size, temp, num_threads, executor);
+
+    const size_t untouched = merge_untouched_prefix(array, size, sorted_size, key_transform<T>());
+
+    merge_sorted_tail_parallel(array + untouched, size - untouched, sorted_size - untouched, temp, num_threads,
+                               executor, key_transform<T>());
+}
+
+template <typename T, typename Executor>
+void radix_sort_append_parallel(T* array, size_t size, size_t sorted_size, Workspace& workspace,
+                                size_t num_threads, Executor& executor)
+{
+    radix_sort_parallel(array + sorted_size, size - sorted_size, workspace, num_threads, executor);
+
+    const size_t untouched = merge_untouched_prefix(array, size, sorted_size, key_transform<T>());
+
+    merge_sorted_tail_parallel(array + untouched, size - untouched, sorted_size - untouched,
+                               workspace.scratch<T>(size - untouched), num_threads, executor, key_transform<T>());
+}
+
+template <typename T>
+void radix_sort_append_parallel(T* array, size_t size, size_t sorted_size, T* temp,
+                                size_t num_threads = std::thread::hardware_concurrency())
+{
+    ThreadExecutor executor;
+    radix_sort_append_parallel(array, size, sorted_size, temp, num_threads, executor);
+}
+
+template <typename T>
+void radix_sort_append_parallel(T* array, size_t size, size_t sorted_size, Workspace& workspace,
+                                size_t num_threads = std::thread::hardware_concurrency())
+{
+    ThreadExecutor executor;
+    radix_sort_append_parallel(array, size, sorted_size, workspace, num_threads, executor);
+}
+
+// Allocates only the part of the N element buffer that the merge needs.
+template <typename T>
+void radix_sort_append_parallel(T* array, size_t size, size_t sorted_size,
+                                size_t num_threads = std::thread::hardware_concurrency())
+{
+    Workspace workspace;
+    radix_sort_append_parallel(array, size, sorted_size, workspace, num_threads);
+}
+
+// The bits of an integer key as they are: partitions by hash bits need no particular order.
+template <typename K>
+struct raw_bits_transform
+{
+    typename std::make_unsigned<K>::type operator()(K key) const
+    {
+        return typename std::make_unsigned<K>::type(key);
+    }
+};
+
+// Widest partition number radix_partition takes, 65536 partitions.
+const unsigned radix_partition_max_bits = 16;
+
+// Partition number of a key for radix_partition: its bits [shift, shift + log2(mask + 1)).
+template <typename U>
+struct partition_digit
+{
+    unsigned shift;
+    U mask;
+
+    size_t operator()(U bits) const
+    {
+        return size_t((bits >> shift) & mask);
+    }
+};
+
+// Scatters keys[begin, end) to the partitions of out. Fanouts of up to 2048 partitions
+// go through the write-combining buffers once the chunk is large enough.
+template <typename K>
+struct partition_keys
+{
+    K* keys;
+    K* keys_out;
+    unsigned num_bits;
+
+    template <typename E, typename F>
+    void operator()(size_t begin, size_t end, size_t* offsets, E extract, F transform) const
+    {
+        if (num_bits <= 8)
+            scatter<256>(begin, end, offsets, extract, transform);
+        else if (num_bits <= 11)
+            scatter<2048>(begin, end, offsets, extract, transform);
+        else
+            copy_with_reordering_direct(keys + begin, keys + end, keys_out, end - begin, offsets, extract, transform);
+    }
+
+    // The write-combining pass flushes all Buckets buckets at the end, the ones past the
+    // fanout are empty.
+    template <size_t Buckets, typename E, typename F>
+    void scatter(size_t begin, size_t end, const size_t* offsets, E extract, F transform) const
+    {
+        size_t freq[Buckets] = { 0 };
+
+        std::copy(offsets, offsets + (size_t(1) << num_bits), freq);
+
+        copy_with_reordering<Buckets>(keys + begin, keys + end, keys_out, end - begin, freq, extract, transform);
+    }
+};
+
+// Scatters keys[begin, end) and the payload that goes with them.
+template <typename K, typename V>
+struct partition_keys_payload
+{
+    K* keys;
+    V* payload;
+    K* keys_out;
+    V* payload_out;
+
+    template <typename E, typename F>
+    void operator()(size_t begin, size_t end, size_t* offsets, E extract, F transform) const
+    {
+        copy_with_reordering_by_key(keys + begin, keys + end, payload + begin, keys_out, payload_out, end - begin,
+                                    offsets, extract, transform);
+    }
+};
+
+// One histogram pass and one scatter pass by bits [bit_offset, bit_offset + num_bits) of
+// the keys, split into num_threads chunks like radix_sort_parallel. Partition p ends up in
+// [bucket_offsets[p], bucket_offsets[p + 1]) of the output, in input order.
+// frequencies must hold max(num_threads, 1) << num_bits zeroed counters.
+template <typename K, typename Scatter, typename Executor>
+void radix_partition_impl(const K* keys, size_t size, unsigned bit_offset, unsigned num_bits, Scatter scatter,
+                          size_t* bucket_offsets, size_t num_threads, Executor& executor, size_t* frequencies)
+{
+    static_assert(std::is_integral<K>::value, "radix_partition partitions integer keys, e.g. hashes");
+
+    using U = typename std::make_unsigned<K>::type;
+
+    const size_t num_buckets = size_t(1) << num_bits;
+    const partition_digit<U> digit = { bit_offset, U(num_buckets - 1) };
+    const raw_bits_transform<K> transform = raw_bits_transform<K>();
+
+    size_t num_chunks = std::min(num_threads, size / parallel_min_chunk_size);
+
+    if (num_chunks < 2)
+    {
+        num_chunks = 1;
+    }
+
+    const size_t chunk_size = size / num_chunks;
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        K* begin = const_cast<K*>(keys) + chunk * chunk_size;
+        K* end = chunk + 1 == num_chunks ? const_cast<K*>(keys) + size : begin + chunk_size;
+
+        count_bytes(begin, end, frequencies + chunk * num_buckets, digit, transform);
+    });
+
+    radix_sort_calculate_offset_table_parallel(frequencies, num_chunks, num_buckets);
+
+    std::copy(frequencies, frequencies + num_buckets, bucket_offsets);
+    bucket_offsets[num_buckets] = size;
+
+    executor(num_chunks, [&](size_t chunk)
+    {
+        const size_t begin = chunk * chunk_size;
+        const size_t end = chunk + 1 == num_chunks ? size : begin + chunk_size;
+
+        scatter(begin, end, frequencies + chunk * num_buckets, digit, transform);
+    });
 }
 
-void radix_sort(uint64_t* array, size_t size, uint64_t* temp)
+// Per-chunk histograms of radix_partition, from the workspace. Checks the bit range first,
+// in release builds too: larger fanouts would shift past the width of size_t or allocate
+// gigabytes of counters.
+template <typename K>
+size_t* radix_partition_tables(Workspace& workspace, unsigned bit_offset, unsigned num_bits, size_t num_threads)
+{
+    if (num_bits < 1 || num_bits > radix_partition_max_bits)
+        throw std::invalid_argument("radix_partition: bits must be 1 to 16");
+
+    if (bit_offset >= sizeof(K) * CHAR_BIT || num_bits > sizeof(K) * CHAR_BIT - bit_offset)
+        throw std::invalid_argument("radix_partition: offset + bits exceeds the width of the key");
+
+    return workspace.tables(std::max(num_threads, size_t(1)) << num_bits);
+}
+
+// radix_partition(K, [V,] N, offset, bits, KO, [VO,] B[, W][, T[, E]]): splits N integer keys
+// (and their payload) into 2^bits partitions by bits [offset, offset + bits) of the keys,
+// e.g. hash bits before a join or a shuffle. Partition p is written to KO[B[p], B[p + 1])
+// (and VO), keeping the input order; B must hold 2^bits + 1 entries. bits must be 1 to 16
+// and offset + bits at most the width of K, or std::invalid_argument is thrown. The
+// histograms are kept in the Workspace W if given. T threads and the executor E work as
+// for radix_sort_parallel. The input is not modified.
+template <typename K, typename Executor>
+void radix_partition(const K* keys, size_t size, unsigned bit_offset, unsigned num_bits, K* out,
+                     size_t* bucket_offsets, Workspace& workspace, size_t num_threads, Executor& executor)
+{
+    size_t* frequencies = radix_partition_tables<K>(workspace, bit_offset, num_bits, num_threads);
+
+    // The scatter passes only read their source.
+    partition_keys<K> scatter = { const_cast<K*>(keys), out, num_bits };
+
+    radix_partition_impl(keys, size, bit_offset, num_bits, scatter, bucket_offsets, num_threads, executor,
+                         frequencies);
+}
+
+template <typename K>
+void radix_partition(const K* keys, size_t size, unsigned bit_offset, unsigned num_bits, K* out,
+                     size_t* bucket_offsets, Workspace& workspace, size_t num_threads = 1)
+{
+    ThreadExecutor executor;
+    radix_partition(keys, size, bit_offset, num_bits, out, bucket_offsets, workspace, num_threads, executor);
+}
+
+template <typename K, typename Executor>
+void radix_partition(const K* keys, size_t size, unsigned bit_offset, unsigned num_bits, K* out,
+                     size_t* bucket_offsets, size_t num_threads, Executor& executor)
+{
+    Workspace workspace;
+    radix_partition(keys, size, bit_offset, num_bits, out, bucket_offsets, workspace, num_threads, executor);
+}
+
+template <typename K>
+void radix_partition(const K* keys, size_t size, unsigned bit_offset, unsigned num_bits, K* out,
+                     size_t* bucket_offsets, size_t num_threads = 1)
+{
+    ThreadExecutor executor;
+    radix_partition(keys, size, bit_offset, num_bits, out, bucket_offsets, num_threads, executor);
+}
+
+template <typename K, typename V, typename Executor>
+void radix_partition(const K* keys, const V* payload, size_t size, unsigned bit_offset, unsigned num_bits,
+                     K* keys_out, V* payload_out, size_t* bucket_offsets, Workspace& workspace,
+                     size_t num_threads, Executor& executor)
+{
+    size_t* frequencies = radix_partition_tables<K>(workspace, bit_offset, num_bits, num_threads);
+
+    partition_keys_payload<K, V> scatter = { const_cast<K*>(keys), const_cast<V*>(payload), keys_out, payload_out };
+
+    radix_partition_impl(keys, size, bit_offset, num_bits, scatter, bucket_offsets, num_threads, executor,
+                         frequencies);
+}
+
+template <typename K, typename V>
+void radix_partition(const K* keys, const V* payload, size_t size, unsigned bit_offset, unsigned num_bits,
+                     K* keys_out, V* payload_out, size_t* bucket_offsets, Workspace& workspace,
+                     size_t num_threads = 1)
+{
+    ThreadExecutor executor;
+    radix_partition(keys, payload, size, bit_offset, num_bits, keys_out, payload_out, bucket_offsets,
+                    workspace, num_threads, executor);
+}
+
+template <typename K, typename V, typename Executor>
+void radix_partition(const K* keys, const V* payload, size_t size, unsigned bit_offset, unsigned num_bits,
+                     K* keys_out, V* payload_out, size_t* bucket_offsets, size_t num_threads, Executor& executor)
+{
+    Workspace workspace;
+    radix_partition(keys, payload, size, bit_offset, num_bits, keys_out, payload_out, bucket_offsets,
+                    workspace, num_threads, executor);
+}
+
+template <typename K, typename V>
+void radix_partition(const K* keys, const V* payload, size_t size, unsigned bit_offset, unsigned num_bits,
+                     K* keys_out, V* payload_out, size_t* bucket_offsets, size_t num_threads = 1)
 {
-    auto identity = [](uint64_t v) -> uint64_t
+    ThreadExecutor executor;
+    radix_partition(keys, payload, size, bit_offset, num_bits, keys_out, payload_out, bucket_offsets,
+                    num_threads, executor);
+}
+
+// Time, traffic and hardware counters of one phase, summed over every time it ran.
+// bytes counts the elements the phase read plus the ones it wrote; for the presorted
+// check it leaves out the reversal of reversed input. The counters are 0 when
+// SortStats::counters_available is false.
+struct SortPhaseStats
+{
+    unsigned runs = 0;
+    double seconds = 0;
+    uint64_t bytes = 0;
+    uint64_t cycles = 0;
+    uint64_t llc_misses = 0;
+    uint64_t dtlb_misses = 0;
+};
+
+// What a radix_sort(..., SortStats&) call spent its time on. passes[i] is the i-th
+// scatter pass of every sort the call ran (a presorted prefix sorts its tail separately),
+// num_passes the number of passes that ran and skipped_passes the number of key bytes
+// that needed none. The hardware counters are read with perf_event_open on Linux and need
+// perf_event_paranoid to allow user space counting.
+struct SortStats
+{
+    SortPhaseStats insertion_sort;
+    SortPhaseStats presorted_check;
+    SortPhaseStats histogram;
+    SortPhaseStats planning;
+    SortPhaseStats passes[8];
+    SortPhaseStats copy_back;
+    SortPhaseStats merge;
+    unsigned num_passes = 0;
+    unsigned skipped_passes = 0;
+    bool counters_available = false;
+
+    SortPhaseStats& phase(SortPhase which, unsigned pass = 0)
     {
-        return v;
-    };
+        switch (which)
+        {
+        case SortPhase::insertion_sort: return insertion_sort;
+        case SortPhase::presorted_check: return presorted_check;
+        case SortPhase::histogram: return histogram;
+        case SortPhase::planning: return planning;
+        case SortPhase::pass: return passes[std::min(pass, 7u)];
+        case SortPhase::copy_back: return copy_back;
+        default: return merge;
+        }
+    }
+};
+
+// Counts cycles, last level cache misses and data TLB read misses of the calling thread
+// in user space. A counter that can't be opened (no permission, no PMU in a VM) reads 0.
+class perf_counters
+{
+public:
+    static const unsigned num_counters = 3;
+
+    perf_counters()
+    {
+        std::fill(fds, fds + num_counters, -1);
+
+#ifdef RADIX_SORT_HAS_PERF_EVENT
+        const uint32_t types[num_counters] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE };
+        const uint64_t configs[num_counters] =
+        {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+        };
+
+        for (unsigned i = 0; i < num_counters; ++i)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+
+            attr.size = sizeof(attr);
+            attr.type = types[i];
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            fds[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    ~perf_counters()
+    {
+#ifdef RADIX_SORT_HAS_PERF_EVENT
+        for (unsigned i = 0; i < num_counters; ++i)
+            if (fds[i] >= 0)
+                close(fds[i]);
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    bool available() const
+    {
+        return std::any_of(fds, fds + num_counters, [](int fd) { return fd >= 0; });
+    }
+
+    void read(uint64_t* values) const
+    {
+        for (unsigned i = 0; i < num_counters; ++i)
+        {
+            values[i] = 0;
+
+#ifdef RADIX_SORT_HAS_PERF_EVENT
+            if (fds[i] >= 0 && ::read(fds[i], &values[i], sizeof(values[i])) != ssize_t(sizeof(values[i])))
+                values[i] = 0;
+#endif
+        }
+    }
+
+private:
+    int fds[num_counters];
+};
+
+// Instrumentation policy that sums the wall time, bytes and counters of every phase into
+// a SortStats.
+class stats_instrumentation
+{
+public:
+    stats_instrumentation(SortStats& stats, const perf_counters& counters) : stats(&stats), counters(&counters) {}
 
-    radix_sort_64_impl(array, size, temp, identity);
+    void begin()
+    {
+        counters->read(start_counters);
+        start = std::chrono::steady_clock::now();
+    }
+
+    void end(SortPhase phase, size_t bytes, unsigned pass = 0)
+    {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        uint64_t end_counters[perf_counters::num_counters];
+        counters->read(end_counters);
+
+        SortPhaseStats& s = stats->phase(phase, pass);
+
+        s.runs++;
+        s.seconds += std::chrono::duration<double>(now - start).count();
+        s.bytes += bytes;
+        s.cycles += end_counters[0] - start_counters[0];
+        s.llc_misses += end_counters[1] - start_counters[1];
+        s.dtlb_misses += end_counters[2] - start_counters[2];
+
+        if (phase == SortPhase::pass)
+            stats->num_passes++;
+    }
+
+    void skipped_passes(unsigned count)
+    {
+        stats->skipped_passes += count;
+    }
+
+private:
+    SortStats* stats;
+    const perf_counters* counters;
+    std::chrono::steady_clock::time_point start;
+    uint64_t start_counters[perf_counters::num_counters];
+};
+
+// Runs the byte radix sort of radix_sort(array, size, temp) with an instrumentation
+// policy, see no_instrumentation for the interface. Without one the sort has no
+// instrumentation code at all. 8 bit keys go through the LSD engine here, not the
+// counting sort of radix_sort.
+template <typename T, typename Instrument>
+void radix_sort_instrumented(T* array, size_t size, T* temp, Instrument instrument)
+{
+    radix_sort_impl(array, size, temp, key_transform<T>(), instrument);
 }
 
-void radix_sort(int64_t * array, size_t size, int64_t* temp)
+// radix_sort that also fills stats with the time, bytes moved and hardware counters of
+// every phase and the number of passes run and skipped. stats is reset first.
+template <typename T>
+void radix_sort(T* array, size_t size, T* temp, SortStats& stats)
+{
+    perf_counters counters;
+
+    stats = SortStats();
+    stats.counters_available = counters.available();
+
+    radix_sort_instrumented(array, size, temp, stats_instrumentation(stats, counters));
+}
+
+template <typename T>
+void radix_sort(T* array, size_t size, SortStats& stats)
+{
+    T * temp = new T[size];
+    radix_sort(array, size, temp, stats);
+    delete[] temp;
+}
+
+template <typename T>
+void radix_sort(T* array, size_t size, Workspace& workspace, SortStats& stats)
+{
+    radix_sort(array, size, workspace.scratch<T>(size), stats);
+}
+
+// Last LSD pass of radix_sort_unique and radix_sort_rle. The elements that land in one
+// bucket of the last pass arrive in sorted order, so an element equal to the previous one
+// written to its bucket is a duplicate: it is written over that one instead of after it,
+// and with_counts adds one to the run length stored at the same position of counts.
+// Afterwards bucket b holds its distinct values in [begin[b], freq[b]).
+template <bool with_counts, typename T, typename ExtractByteFuncT, typename BitwiseTransformFuncT>
+void copy_runs_with_reordering(const T* src, size_t size, T* dst, size_t* counts, const size_t* begin,
+                               size_t* freq, ExtractByteFuncT extract_byte_f,
+                               BitwiseTransformFuncT bitwise_transform_f)
 {
-    auto flip_sign = [](int64_t v) -> uint64_t
+    using Ret = decltype(bitwise_transform_f(std::declval<T&>()));
+
+    // Everything the loop needs about one bucket in one place, so that an element touches
+    // one cache line of state instead of four. Being local, it can't alias counts either.
+    struct bucket_state
     {
-        return *reinterpret_cast<uint64_t*>(&v) ^ (uint64_t(1) << 63);
+        size_t position;
+        size_t start;
+        size_t run_length;
+        Ret last;
     };
 
-    radix_sort_64_impl(array, size, temp, flip_sign);
+    bucket_state state[256];
+
+    for (size_t b = 0; b < 256; ++b)
+    {
+        state[b].position = freq[b];
+        state[b].start = begin[b];
+        state[b].run_length = 0;
+        state[b].last = Ret();
+    }
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        const Ret key = bitwise_transform_f(src[i]);
+        bucket_state& bucket = state[extract_byte_f(key)];
+        const size_t position = bucket.position;
+        const bool same = position != bucket.start && key == bucket.last;
+
+        // A duplicate is written to the next free slot of its bucket too, which the next
+        // distinct value overwrites: that keeps the address from waiting on the comparison.
+        dst[position] = src[i];
+
+        const size_t next = position + !same;
+
+        // The current run length of every bucket is kept here, so that counts is only written.
+        if (with_counts)
+        {
+            bucket.run_length = same ? bucket.run_length + 1 : 1;
+            counts[next - 1] = bucket.run_length;
+        }
+
+        bucket.position = next;
+        bucket.last = key;
+    }
+
+    for (size_t b = 0; b < 256; ++b)
+        freq[b] = state[b].position;
 }
 
-void radix_sort(float* array, size_t size, float* temp)
+// Runs of equal elements in a sorted array: moves the first element of every run to the
+// front and, if counts isn't null, stores the run lengths in counts. Returns the number of runs.
+template <typename T, typename F>
+size_t sorted_runs(T* array, size_t size, size_t* counts, F bitwise_transform)
 {
-    static_assert(std::numeric_limits<float>::is_iec559, "Only IEEE 754 floating point");
+    size_t num_runs = 0;
 
-    auto flip = [](float v) -> uint32_t
+    for (size_t begin = 0; begin < size;)
     {
-        uint32_t as_uint = *reinterpret_cast<uint32_t*>(&v);
-        uint32_t mask = -int32_t(as_uint >> 31) | (uint32_t(1) << 31);
-        return as_uint ^ mask;
-    };
+        const auto key = bitwise_transform(array[begin]);
+
+        size_t end = begin + 1;
+
+        while (end < size && bitwise_transform(array[end]) == key)
+            ++end;
+
+        array[num_runs] = array[begin];
 
-    radix_sort_32_impl(array, size, temp, flip);
+        if (counts)
+            counts[num_runs] = end - begin;
+
+        ++num_runs;
+        begin = end;
+    }
+
+    return num_runs;
 }
 
-void radix_sort(uint8_t * array, size_t size)
-{    
-    size_t frequencies[1 << CHAR_BIT] = { 0 };
+// Sorts array and keeps the first element of every run of equal keys, with the run
+// lengths in counts if it isn't null; returns the number of runs. The last LSD pass
+// drops the duplicates as it scatters (copy_runs_with_reordering) and the distinct values
+// of every bucket are then moved together into array. temp must hold size elements,
+// counts (if not null) size entries.
+template <size_t num_bytes, typename T, typename F>
+size_t radix_sort_runs_impl(T* array, size_t size, T* temp, size_t* counts, F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    if (size < small_sort_threshold(num_bytes))
+    {
+        insertion_sort(array, size, bitwise_transform);
+        return sorted_runs(array, size, counts, bitwise_transform);
+    }
+
+    if (presorted_prefix(array, size, bitwise_transform) == size)
+        return sorted_runs(array, size, counts, bitwise_transform);
+
+    size_t frequencies[num_bytes][256] = { { 0 } };
 
-    for(size_t i = 0; i < size; ++i)
-        ++frequencies[array[i]];
+    radix_sort_histogram(array, size, frequencies, bitwise_transform);
 
-    size_t write_index = 0;
+    unsigned shifts[num_bytes];
 
-    for(size_t value = 0; value < (1 << CHAR_BIT); ++value)
+    const unsigned num_passes = radix_sort_plan_passes<num_bytes>(array, size, frequencies, bitwise_transform,
+                                                                  shifts, no_instrumentation());
+
+    // All elements are equal.
+    if (num_passes == 0)
+    {
+        if (counts)
+            counts[0] = size;
+
+        return 1;
+    }
+
+    T* src = array;
+    T* dst = temp;
+
+    for (unsigned pass = 0; pass + 1 < num_passes; ++pass)
+    {
+        const unsigned shift = shifts[pass];
+
+        auto extract_byte = [shift](Ret v) -> size_t
+        {
+            return (v >> shift) & 255;
+        };
+
+        copy_with_reordering(src, src + size, dst, size, frequencies[pass], extract_byte, bitwise_transform);
+
+        std::swap(src, dst);
+    }
+
+    const unsigned shift = shifts[num_passes - 1];
+
+    auto extract_byte = [shift](Ret v) -> size_t
+    {
+        return (v >> shift) & 255;
+    };
+
+    size_t* freq = frequencies[num_passes - 1];
+    size_t begin[256];
+
+    std::copy(freq, freq + 256, begin);
+
+    if (counts)
+        copy_runs_with_reordering<true>(src, size, dst, counts, begin, freq, extract_byte, bitwise_transform);
+    else
+        copy_runs_with_reordering<false>(src, size, dst, counts, begin, freq, extract_byte, bitwise_transform);
+
+    // Close the gaps the duplicates left at the end of every bucket. In place that moves
+    // nothing before the first duplicate.
+    size_t num_runs = 0;
+
+    for (size_t bucket = 0; bucket < 256; ++bucket)
     {
-        size_t element_count = frequencies[value];
+        const size_t length = freq[bucket] - begin[bucket];
 
-        for (size_t i = 0; i < element_count; ++i, ++write_index)
-            array[write_index] = uint8_t(value);
+        if (dst != array || num_runs != begin[bucket])
+            std::copy(dst + begin[bucket], dst + freq[bucket], array + num_runs);
+
+        if (counts && num_runs != begin[bucket])
+            std::copy(counts + begin[bucket], counts + freq[bucket], counts + num_runs);
+
+        num_runs += length;
     }
+
+    return num_runs;
 }
 
-void radix_sort(int8_t * array, size_t size)
+template <typename T>
+size_t radix_sort_runs(T* array, size_t size, T* temp, size_t* counts)
 {
-    size_t frequencies[1 << CHAR_BIT] = { 0 };
+    using Ret = decltype(key_transform<T>()(std::declval<T&>()));
+
+    return radix_sort_runs_impl<sizeof(Ret)>(array, size, temp, counts, key_transform<T>());
+}
 
-    for(size_t i = 0; i < size; ++i)
-        ++frequencies[int32_t(array[i]) + int32_t(128)];
+// 8 and 16 bit keys: the counting sort histogram already holds every value's count.
+// counts must hold counting_sort_buckets<T>() zeros.
+template <typename T>
+size_t counted_runs(T* array, size_t size, size_t* counts, size_t* run_counts)
+{
+    const T min_value = std::numeric_limits<T>::min();
 
-    size_t write_index = 0;
+    if (sizeof(T) == 1)
+        counting_sort_histogram_8(array, size, counts);
+    else
+        counting_sort_histogram(array, size, counts, min_value);
 
-    for(int32_t value = 0; value < (1 << CHAR_BIT); ++value)
+    size_t num_runs = 0;
+
+    for (size_t bucket = 0; bucket < counting_sort_buckets<T>(); ++bucket)
     {
-        size_t element_count = frequencies[value];
+        if (counts[bucket] == 0)
+            continue;
+
+        array[num_runs] = counting_value<T>(bucket, min_value);
 
-        const int8_t write_value = int8_t(value - int32_t(128));
+        if (run_counts)
+            run_counts[num_runs] = counts[bucket];
 
-        for (size_t i = 0; i < element_count; ++i, ++write_index)
-            array[write_index] = write_value;
+        ++num_runs;
     }
+
+    return num_runs;
 }
 
 template <typename T>
-void radix_sort(T* array, size_t size)
+size_t radix_sort_runs(T* array, size_t size, T* temp, size_t* counts, Workspace* workspace,
+                       std::false_type /* counting sort key */)
 {
-    T * temp = new T[size];
-    radix_sort(array, size, temp);
-    delete[] temp;
+    if (temp)
+        return radix_sort_runs(array, size, temp, counts);
+
+    if (workspace)
+        return radix_sort_runs(array, size, workspace->scratch<T>(size), counts);
+
+    std::vector<T> buffer(size);
+    return radix_sort_runs(array, size, buffer.data(), counts);
+}
+
+template <typename T>
+size_t radix_sort_runs(T* array, size_t size, T* temp, size_t* counts, Workspace* workspace,
+                       std::true_type /* counting sort key */)
+{
+    if (!counting_sort_pays_off<T>(size))
+        return radix_sort_runs(array, size, temp, counts, workspace, std::false_type());
+
+    if (workspace)
+        return counted_runs(array, size, workspace->tables(counting_sort_buckets<T>()), counts);
+
+    std::vector<size_t> table(counting_sort_buckets<T>());
+    return counted_runs(array, size, table.data(), counts);
+}
+
+template <typename T>
+size_t radix_sort_runs(T* array, size_t size, T* temp, size_t* counts, Workspace* workspace)
+{
+    return radix_sort_runs(array, size, temp, counts, workspace, is_counting_sort_key<T>());
+}
+
+// Sorts array and removes duplicates in the same pass: returns the number of distinct
+// values, which are left sorted in array[0, returned). Values are compared by their bits,
+// so -0.0 and +0.0 are distinct. temp, if given, must hold size elements; 8 bit keys and
+// 16 bit keys from counting_sort_threshold elements on don't use it.
+template <typename T>
+size_t radix_sort_unique(T* array, size_t size, T* temp)
+{
+    return radix_sort_runs<T>(array, size, temp, nullptr, nullptr);
+}
+
+template <typename T>
+size_t radix_sort_unique(T* array, size_t size)
+{
+    return radix_sort_runs<T>(array, size, nullptr, nullptr, nullptr);
+}
+
+template <typename T>
+size_t radix_sort_unique(T* array, size_t size, Workspace& workspace)
+{
+    return radix_sort_runs<T>(array, size, nullptr, nullptr, &workspace);
+}
+
+// Run-length encoded sort: like radix_sort_unique, and counts[i] is the number of times
+// array[i] occurred. counts must hold size entries.
+template <typename T>
+size_t radix_sort_rle(T* array, size_t size, size_t* counts, T* temp)
+{
+    return radix_sort_runs<T>(array, size, temp, counts, nullptr);
+}
+
+template <typename T>
+size_t radix_sort_rle(T* array, size_t size, size_t* counts)
+{
+    return radix_sort_runs<T>(array, size, nullptr, counts, nullptr);
+}
+
+template <typename T>
+size_t radix_sort_rle(T* array, size_t size, size_t* counts, Workspace& workspace)
+{
+    return radix_sort_runs<T>(array, size, nullptr, counts, &workspace);
+}
+
+// Sorts array and writes the start of every group of equal values to offsets, followed by
+// size: group i is array[offsets[i], offsets[i + 1]). Returns the number of groups.
+// offsets must hold size + 1 entries. The distinct values and their counts come out of the
+// fused last pass, and array is then filled back in from them, from the back, so the sorted
+// array is never read again to find the group boundaries.
+template <typename T>
+size_t radix_sort_group_offsets(T* array, size_t size, size_t* offsets, T* temp, Workspace* workspace)
+{
+    const size_t num_groups = radix_sort_runs<T>(array, size, temp, offsets, workspace);
+
+    // The last value of group i ends at the sum of the counts up to i, which is never
+    // before position i, so no value is overwritten before it is read.
+    size_t end = size;
+
+    for (size_t group = num_groups; group-- > 0;)
+    {
+        const size_t count = offsets[group];
+
+        fill_run(array + end - count, count, array[group]);
+        end -= count;
+        offsets[group] = end;
+    }
+
+    offsets[num_groups] = size;
+
+    return num_groups;
+}
+
+template <typename T>
+size_t radix_sort_group_offsets(T* array, size_t size, size_t* offsets, T* temp)
+{
+    return radix_sort_group_offsets(array, size, offsets, temp, nullptr);
+}
+
+template <typename T>
+size_t radix_sort_group_offsets(T* array, size_t size, size_t* offsets)
+{
+    return radix_sort_group_offsets(array, size, offsets, static_cast<T*>(nullptr), nullptr);
+}
+
+template <typename T>
+size_t radix_sort_group_offsets(T* array, size_t size, size_t* offsets, Workspace& workspace)
+{
+    return radix_sort_group_offsets(array, size, offsets, static_cast<T*>(nullptr), &workspace);
 }
 
 }; // end namespace RadixSort
@@ -0,0 +1,270 @@
+#include "radix_sort.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cerrno>
+#include <cstdlib>
+#include <functional>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifndef RADIX_SORT_EXTERNAL_H
+#define RADIX_SORT_EXTERNAL_H
+
+namespace RadixSort {
+
+// Largest single read or write request, Linux transfers at most about 2 GB per call.
+const size_t external_io_chunk = size_t(1) << 30;
+
+// Closes the file descriptor when it goes out of scope.
+struct file_descriptor
+{
+    int fd;
+
+    explicit file_descriptor(int fd) : fd(fd) {}
+    ~file_descriptor() { if (fd >= 0) close(fd); }
+
+    file_descriptor(const file_descriptor&) = delete;
+    file_descriptor& operator=(const file_descriptor&) = delete;
+};
+
+inline bool read_full(int fd, void* data, size_t bytes, uint64_t offset)
+{
+    char* p = static_cast<char*>(data);
+
+    while (bytes > 0)
+    {
+        ssize_t n = pread(fd, p, std::min(bytes, external_io_chunk), off_t(offset));
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            return false;
+
+        p += n;
+        bytes -= size_t(n);
+        offset += uint64_t(n);
+    }
+
+    return true;
+}
+
+inline bool write_full(int fd, const void* data, size_t bytes, uint64_t offset)
+{
+    const char* p = static_cast<const char*>(data);
+
+    while (bytes > 0)
+    {
+        ssize_t n = pwrite(fd, p, std::min(bytes, external_io_chunk), off_t(offset));
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            return false;
+
+        p += n;
+        bytes -= size_t(n);
+        offset += uint64_t(n);
+    }
+
+    return true;
+}
+
+// Creates an anonymous file in directory, it is deleted as soon as it is closed.
+inline int open_spill_file(const std::string& directory)
+{
+    std::string path = (directory.empty() ? std::string(".") : directory) + "/radix_sort_XXXXXX";
+
+    int fd = mkstemp(&path[0]);
+
+    if (fd >= 0)
+        unlink(path.c_str());
+
+    return fd;
+}
+
+inline std::string parent_directory(const char* path)
+{
+    std::string s(path);
+    size_t slash = s.find_last_of('/');
+
+    if (slash == std::string::npos)
+        return ".";
+
+    return slash == 0 ? "/" : s.substr(0, slash);
+}
+
+// One sorted run in the spill file, [next, end) are the elements not read yet,
+// buffer[head, count) the ones read but not merged yet.
+template <typename T>
+struct external_run
+{
+    uint64_t next;
+    uint64_t end;
+    T* buffer;
+    size_t head;
+    size_t count;
+};
+
+template <typename T, typename F>
+bool external_merge(int spill, int output, std::vector<external_run<T>>& runs, T* buffer, size_t buffer_size,
+                    F bitwise_transform)
+{
+    using Ret = decltype(bitwise_transform(std::declval<T&>()));
+
+    const size_t num_runs = runs.size();
+    const size_t chunk = buffer_size / (num_runs + 1);
+
+    auto refill = [spill, chunk](external_run<T>& run) -> bool
+    {
+        run.head = 0;
+        run.count = size_t(std::min(uint64_t(chunk), run.end - run.next));
+        run.next += run.count;
+
+        return read_full(spill, run.buffer, run.count * sizeof(T), (run.next - run.count) * sizeof(T));
+    };
+
+    // Min-heap of (key, run) on the first unmerged element of every run.
+    std::vector<std::pair<Ret, size_t>> heap;
+    std::greater<std::pair<Ret, size_t>> later;
+
+    for (size_t i = 0; i < num_runs; ++i)
+    {
+        runs[i].buffer = buffer + i * chunk;
+
+        if (!refill(runs[i]))
+            return false;
+
+        heap.push_back(std::make_pair(bitwise_transform(runs[i].buffer[0]), i));
+    }
+
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    T* out = buffer + num_runs * chunk;
+    const size_t out_size = buffer_size - num_runs * chunk;
+    size_t out_count = 0;
+    uint64_t out_offset = 0;
+
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), later);
+
+        external_run<T>& run = runs[heap.back().second];
+
+        out[out_count++] = run.buffer[run.head++];
+
+        if (out_count == out_size)
+        {
+            if (!write_full(output, out, out_count * sizeof(T), out_offset))
+                return false;
+
+            out_offset += out_count * sizeof(T);
+            out_count = 0;
+        }
+
+        if (run.head == run.count && run.next != run.end && !refill(run))
+            return false;
+
+        if (run.head != run.count)
+        {
+            heap.back().first = bitwise_transform(run.buffer[run.head]);
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+        else
+        {
+            heap.pop_back();
+        }
+    }
+
+    return write_full(output, out, out_count * sizeof(T), out_offset);
+}
+
+// Sorts a file of raw T values that is larger than memory. The input is read in runs of
+// memory_bytes / (2 * sizeof(T)) elements, each run is sorted with radix_sort into a reused
+// temporary buffer and appended to a spill file, then all runs are merged into the output
+// with one k-way merge, splitting the same memory into one read buffer per run plus a write
+// buffer. If the whole file fits in one run nothing is spilled.
+// The spill file is created in temp_directory, or next to the output file if it is null,
+// and needs as much free space as the input. input_path and output_path may be the same file.
+// Returns false if a file can't be opened, read or written, or its size is not a multiple
+// of sizeof(T); the output is then incomplete.
+template <typename T>
+bool radix_sort_file(const char* input_path, const char* output_path, size_t memory_bytes,
+                     const char* temp_directory = nullptr)
+{
+    const size_t run_size = std::max(memory_bytes / (2 * sizeof(T)), size_t(1));
+
+    file_descriptor input(open(input_path, O_RDONLY));
+
+    if (input.fd < 0)
+        return false;
+
+    struct stat status;
+
+    if (fstat(input.fd, &status) != 0 || uint64_t(status.st_size) % sizeof(T) != 0)
+        return false;
+
+    const uint64_t size = uint64_t(status.st_size) / sizeof(T);
+
+    posix_fadvise(input.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<T> buffer(size_t(std::min(uint64_t(2 * run_size), 2 * size)));
+    T* temp = buffer.data() + buffer.size() / 2;
+
+    if (size <= run_size)
+    {
+        if (!read_full(input.fd, buffer.data(), size_t(size) * sizeof(T), 0))
+            return false;
+
+        radix_sort_impl(buffer.data(), size_t(size), temp, key_transform<T>());
+
+        file_descriptor output(open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+
+        return output.fd >= 0 && write_full(output.fd, buffer.data(), size_t(size) * sizeof(T), 0);
+    }
+
+    file_descriptor spill(open_spill_file(temp_directory ? std::string(temp_directory)
+                                                         : parent_directory(output_path)));
+
+    if (spill.fd < 0)
+        return false;
+
+    std::vector<external_run<T>> runs;
+
+    for (uint64_t begin = 0; begin < size; begin += run_size)
+    {
+        const size_t count = size_t(std::min(uint64_t(run_size), size - begin));
+
+        if (!read_full(input.fd, buffer.data(), count * sizeof(T), begin * sizeof(T)))
+            return false;
+
+        radix_sort_impl(buffer.data(), count, temp, key_transform<T>());
+
+        if (!write_full(spill.fd, buffer.data(), count * sizeof(T), begin * sizeof(T)))
+            return false;
+
+        runs.push_back(external_run<T>{ begin, begin + count, nullptr, 0, 0 });
+    }
+
+    file_descriptor output(open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+
+    if (output.fd < 0)
+        return false;
+
+    posix_fadvise(spill.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // Every run needs at least one element of read buffer, and the output one more.
+    if (buffer.size() < runs.size() + 1)
+        buffer.resize(runs.size() + 1);
+
+    return external_merge(spill.fd, output.fd, runs, buffer.data(), buffer.size(), key_transform<T>());
+}
+
+}; // end namespace RadixSort
+#endif //RADIX_SORT_EXTERNAL_H
@@ -0,0 +1,272 @@
+#include "radix_sort.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstring>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#ifndef RADIX_SORT_STRING_H
+#define RADIX_SORT_STRING_H
+
+namespace RadixSort {
+
+// One string being sorted. cache holds the 8 bytes of the string that start at the
+// current cache depth, most significant first and zero padded, so that most digit
+// lookups read the entry itself instead of chasing data.
+struct string_entry
+{
+    uint64_t cache;
+    const char* data;
+    size_t size;
+    size_t index;
+};
+
+// Buckets smaller than this are finished with multikey quicksort.
+const size_t string_msd_threshold = 32;
+
+// 257 digits per position: 0 for strings that end before depth, 1 + byte otherwise.
+const size_t string_buckets = 257;
+
+inline uint64_t load_string_cache(const string_entry& e, size_t depth)
+{
+    unsigned char bytes[8] = { 0 };
+
+    if (depth < e.size)
+        std::memcpy(bytes, e.data + depth, std::min(e.size - depth, size_t(8)));
+
+    uint64_t cache = 0;
+
+    for (size_t i = 0; i < 8; ++i)
+        cache = (cache << 8) | bytes[i];
+
+    return cache;
+}
+
+inline size_t string_digit(const string_entry& e, size_t depth)
+{
+    return depth < e.size ? 1 + size_t((unsigned char)e.data[depth]) : 0;
+}
+
+inline size_t cached_string_digit(const string_entry& e, size_t depth, size_t cache_depth)
+{
+    return depth < e.size ? 1 + size_t((e.cache >> ((7 - (depth - cache_depth)) * CHAR_BIT)) & 255) : 0;
+}
+
+// Multikey quicksort (Bentley and Sedgewick) on the suffixes that start at depth.
+inline void multikey_quicksort(string_entry* array, size_t size, size_t depth)
+{
+    while (size > 1)
+    {
+        if (size < 8)
+        {
+            for (size_t i = 1; i < size; ++i)
+            {
+                string_entry value = array[i];
+                size_t j = i;
+
+                for (; j > 0; --j)
+                {
+                    const string_entry& prev = array[j - 1];
+                    // Both strings are at least depth long and equal up to depth.
+                    size_t common = std::min(prev.size, value.size) - depth;
+                    int c = common ? std::memcmp(prev.data + depth, value.data + depth, common) : 0;
+
+                    if (c < 0 || (c == 0 && prev.size <= value.size))
+                        break;
+
+                    array[j] = prev;
+                }
+
+                array[j] = value;
+            }
+
+            return;
+        }
+
+        size_t a = string_digit(array[0], depth);
+        size_t b = string_digit(array[size / 2], depth);
+        size_t c = string_digit(array[size - 1], depth);
+        size_t pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+        // Three way partition: [0, lt) < pivot, [lt, gt) == pivot, [gt, size) > pivot.
+        size_t lt = 0;
+        size_t gt = size;
+
+        for (size_t i = 0; i < gt;)
+        {
+            size_t d = string_digit(array[i], depth);
+
+            if (d < pivot)
+                std::swap(array[lt++], array[i++]);
+            else if (d > pivot)
+                std::swap(array[i], array[--gt]);
+            else
+                ++i;
+        }
+
+        multikey_quicksort(array, lt, depth);
+        multikey_quicksort(array + gt, size - gt, depth);
+
+        if (pivot == 0)
+            return;
+
+        array += lt;
+        size = gt - lt;
+        ++depth;
+    }
+}
+
+// A bucket of string_radix_sort_impl still to be sorted: array[begin, begin + size),
+// equal up to depth, with caches loaded at cache_depth.
+struct string_bucket
+{
+    size_t begin;
+    size_t size;
+    size_t depth;
+    size_t cache_depth;
+};
+
+// MSD radix sort with 257-way buckets on the cached prefixes. temp and digits must
+// hold at least size elements. Buckets are kept on an explicit stack instead of
+// recursing, so long shared prefixes don't exhaust the call stack.
+inline void string_radix_sort_impl(string_entry* array, size_t size, string_entry* temp, uint16_t* digits)
+{
+    std::vector<string_bucket> pending(1, string_bucket{ 0, size, 0, 0 });
+
+    size_t ends[string_buckets];
+    size_t heads[string_buckets];
+
+    while (!pending.empty())
+    {
+        string_bucket bucket = pending.back();
+        pending.pop_back();
+
+        string_entry* entries = array + bucket.begin;
+
+        for (;;)
+        {
+            if (bucket.size < string_msd_threshold)
+            {
+                multikey_quicksort(entries, bucket.size, bucket.depth);
+                break;
+            }
+
+            if (bucket.depth - bucket.cache_depth == 8)
+            {
+                for (size_t i = 0; i < bucket.size; ++i)
+                    entries[i].cache = load_string_cache(entries[i], bucket.depth);
+
+                bucket.cache_depth = bucket.depth;
+            }
+
+            std::fill(ends, ends + string_buckets, size_t(0));
+
+            for (size_t i = 0; i < bucket.size; ++i)
+            {
+                digits[i] = uint16_t(cached_string_digit(entries[i], bucket.depth, bucket.cache_depth));
+                ends[digits[i]]++;
+            }
+
+            // All strings share this byte: move on to the next one without reordering.
+            if (ends[digits[0]] == bucket.size)
+            {
+                if (digits[0] == 0)
+                    break;
+
+                ++bucket.depth;
+                continue;
+            }
+
+            size_t offset = 0;
+
+            for (size_t i = 0; i < string_buckets; ++i)
+            {
+                heads[i] = offset;
+                offset += ends[i];
+                ends[i] = offset;
+            }
+
+            for (size_t i = 0; i < bucket.size; ++i)
+                temp[heads[digits[i]]++] = entries[i];
+
+            std::copy(temp, temp + bucket.size, entries);
+
+            // Bucket 0 holds the strings that ended, they are all equal.
+            for (size_t i = string_buckets - 1; i > 0; --i)
+            {
+                size_t begin = ends[i - 1];
+
+                if (ends[i] - begin > 1)
+                    pending.push_back(string_bucket{ bucket.begin + begin, ends[i] - begin, bucket.depth + 1,
+                                                     bucket.cache_depth });
+            }
+
+            break;
+        }
+    }
+}
+
+inline void string_radix_sort(string_entry* array, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        array[i].cache = load_string_cache(array[i], 0);
+
+    std::vector<string_entry> temp(size);
+    std::vector<uint16_t> digits(size);
+
+    string_radix_sort_impl(array, size, temp.data(), digits.data());
+}
+
+// Sorts (pointer, length) pairs lexicographically by their bytes, compared as unsigned
+// char like memcmp and std::string. Strings may contain zero bytes. Not stable.
+inline void radix_sort_strings(std::pair<const char*, size_t>* array, size_t size)
+{
+    std::vector<string_entry> entries(size);
+
+    for (size_t i = 0; i < size; ++i)
+        entries[i] = string_entry{ 0, array[i].first, array[i].second, i };
+
+    string_radix_sort(entries.data(), size);
+
+    for (size_t i = 0; i < size; ++i)
+        array[i] = std::make_pair(entries[i].data, entries[i].size);
+}
+
+inline void radix_sort_strings(std::string* array, size_t size)
+{
+    std::vector<string_entry> entries(size);
+
+    for (size_t i = 0; i < size; ++i)
+        entries[i] = string_entry{ 0, array[i].data(), array[i].size(), i };
+
+    string_radix_sort(entries.data(), size);
+
+    std::vector<std::string> sorted(size);
+
+    for (size_t i = 0; i < size; ++i)
+        sorted[i] = std::move(array[entries[i].index]);
+
+    std::move(sorted.begin(), sorted.end(), array);
+}
+
+#if __cplusplus >= 201703L
+inline void radix_sort_strings(std::string_view* array, size_t size)
+{
+    std::vector<string_entry> entries(size);
+
+    for (size_t i = 0; i < size; ++i)
+        entries[i] = string_entry{ 0, array[i].data(), array[i].size(), i };
+
+    string_radix_sort(entries.data(), size);
+
+    for (size_t i = 0; i < size; ++i)
+        array[i] = std::string_view(entries[i].data, entries[i].size);
+}
+#endif
+
+}; // end namespace RadixSort
+#endif //RADIX_SORT_STRING_H